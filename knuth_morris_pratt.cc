@@ -1,27 +1,75 @@
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <vector>
 #include <cassert>
+#include <bit>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <memory_resource>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <new>
+#include <memory>
+#include <ranges>
+#include <coroutine>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <deque>
+#include <queue>
+#include <tuple>
+#include <set>
+#include <unordered_set>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <compare>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
 /**
- * @brief Computes the Longest Proper Prefix Suffix (LPS) array for a given pattern.
- *
- * The LPS array is used in the KMP string searching algorithm.
- * For a pattern `pattern`, lps[i] stores the length of the longest proper prefix
- * of pattern[0..i] which is also a suffix of pattern[0..i].
- * A proper prefix or suffix of a string is a prefix or suffix that is not equal to the string itself.
+ * @brief Computes the LPS array for a pattern into a caller-provided buffer.
  *
  * @param pattern The pattern string for which to compute the LPS array.
- * @return A vector of integers representing the LPS array for the given pattern.
+ * @param lps Output buffer; must hold at least pattern.length() elements. Only the first
+ *            pattern.length() elements are written.
  *
  * @note Time Complexity: O(m), where m is the length of the pattern.
- * @note Space Complexity: O(m) for storing the LPS array.
+ * @note Space Complexity: O(1) beyond the output buffer.
  */
-vector<int> computeLPS(const string& pattern) {
+void computeLPS(string_view pattern, span<int> lps) {
     int m = pattern.length();
-    vector<int> lps(m, 0);
+    assert(lps.size() >= (size_t)m);
+    if (m == 0) {
+        return;
+    }
+    lps[0] = 0;
     int i = 1;
     int j = 0;
     while (i < m) {
@@ -38,9 +86,94 @@ vector<int> computeLPS(const string& pattern) {
             }
         }
     }
+}
+
+/**
+ * @brief Computes the Longest Proper Prefix Suffix (LPS) array for a given pattern.
+ *
+ * The LPS array is used in the KMP string searching algorithm.
+ * For a pattern `pattern`, lps[i] stores the length of the longest proper prefix
+ * of pattern[0..i] which is also a suffix of pattern[0..i].
+ * A proper prefix or suffix of a string is a prefix or suffix that is not equal to the string itself.
+ *
+ * @param pattern The pattern string for which to compute the LPS array.
+ * @return A vector of integers representing the LPS array for the given pattern.
+ *
+ * @note Time Complexity: O(m), where m is the length of the pattern.
+ * @note Space Complexity: O(m) for storing the LPS array.
+ */
+vector<int> computeLPS(string_view pattern) {
+    vector<int> lps(pattern.length());
+    computeLPS(pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief Computes the LPS array for a pattern, allocating it from a memory resource.
+ *
+ * @param pattern The pattern string for which to compute the LPS array.
+ * @param resource The memory resource the result is allocated from, e.g. a per-request
+ *                 std::pmr::monotonic_buffer_resource.
+ * @return The LPS array as a std::pmr::vector using resource.
+ */
+pmr::vector<int> computeLPS(string_view pattern, pmr::memory_resource* resource) {
+    pmr::vector<int> lps(pattern.length(), resource);
+    computeLPS(pattern, lps);
     return lps;
 }
 
+/**
+ * @brief Runs the KMP search loop against a pattern given as raw bytes and LPS table.
+ */
+template <class Table>
+void KMPSearchWithTable(string_view text, const char* pattern, const Table* lps_pattern, int m, span<int> lps) {
+    size_t n = text.length();
+    size_t i = 0; // index for text
+    int j = 0; // index for pattern
+    while (i < n) {
+        if (pattern[j] == text[i]) {
+            j++;
+            lps[i] = j;
+            i++;
+        }
+        if (j == m) {
+            j = lps_pattern[j - 1];
+        } else if (i < n && pattern[j] != text[i]) {
+            if (j != 0) {
+                j = lps_pattern[j - 1];
+            } else {
+                lps[i] = 0;
+                i++;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Runs the KMP search writing the pattern table and the result into caller-provided buffers.
+ *
+ * Nothing is allocated, so the same buffers can be reused across calls.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @param lps_pattern Scratch buffer for the pattern's LPS array; at least pattern.length() elements.
+ * @param lps Output buffer; at least text.length() elements. lps[i] receives the same value as
+ *            KMPSearch(text, pattern)[i]. Nothing is written if the pattern is empty.
+ *
+ * @note Time Complexity: O(n + m).
+ * @note Space Complexity: O(1) beyond the buffers.
+ */
+void KMPSearch(string_view text, string_view pattern, span<int> lps_pattern, span<int> lps) {
+    size_t n = text.length();
+    int m = pattern.length();
+    assert(lps.size() >= n);
+    if (m == 0) {
+        return;
+    }
+    computeLPS(pattern, lps_pattern);
+    KMPSearchWithTable(text, pattern.data(), lps_pattern.data(), m, lps);
+}
+
 /**
  * @brief Implements the Knuth-Morris-Pratt (KMP) string searching algorithm.
  *
@@ -55,35 +188,2755 @@ vector<int> computeLPS(const string& pattern) {
  * @note Time Complexity: O(n + m), where n is the length of the text and m is the length of the pattern.
  * @note Space Complexity: O(m + n), where m is the length of the pattern and n is the length of the text.
  */
-vector<int> KMPSearch(const string& text, const string& pattern) {
-    int n = text.length();
+vector<int> KMPSearch(string_view text, string_view pattern) {
     int m = pattern.length();
     if (m == 0) {
         return {};
     }
+    vector<int> lps_pattern(m);
+    vector<int> lps(text.length());
+    KMPSearch(text, pattern, lps_pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief Runs the KMP search, allocating the pattern table and the result from a memory resource.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @param resource The memory resource all allocations are served from.
+ * @return The same values as KMPSearch(text, pattern), as a std::pmr::vector using resource.
+ */
+pmr::vector<int> KMPSearch(string_view text, string_view pattern, pmr::memory_resource* resource) {
+    int m = pattern.length();
+    if (m == 0) {
+        return pmr::vector<int>(resource);
+    }
+    pmr::vector<int> lps_pattern(m, resource);
+    pmr::vector<int> lps(text.length(), resource);
+    KMPSearch(text, pattern, lps_pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief Views a byte buffer as a string_view, without copying.
+ */
+string_view asStringView(span<const byte> bytes) {
+    return string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/**
+ * @brief Computes the LPS array for a pattern held in a raw byte buffer.
+ *
+ * @param pattern The pattern bytes, e.g. from a mapped file or a network buffer.
+ * @return The same values as computeLPS on the pattern viewed as characters.
+ */
+vector<int> computeLPS(span<const byte> pattern) {
+    return computeLPS(asStringView(pattern));
+}
+
+/**
+ * @brief Runs the KMP search over raw byte buffers, without copying them into strings.
+ *
+ * @param text The text bytes, e.g. an mmap'd region.
+ * @param pattern The pattern bytes.
+ * @return The same values as KMPSearch on the buffers viewed as characters.
+ */
+vector<int> KMPSearch(span<const byte> text, span<const byte> pattern) {
+    return KMPSearch(asStringView(text), asStringView(pattern));
+}
+
+/**
+ * @brief Finds the last occurrence of a pattern by running KMP from the end of the text.
+ *
+ * The text is scanned right to left against the reversed pattern, using the LPS array of the
+ * reversed pattern as the failure function. The scan stops at the first full match it meets,
+ * which is the rightmost occurrence, so tails of long texts are answered without a full forward scan.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @return The starting index of the last occurrence of pattern in text, or string::npos if the
+ *         pattern does not occur (or is empty).
+ *
+ * @note Time Complexity: O(m + k), where m is the length of the pattern and k is the number of
+ *       characters scanned from the end of the text before the match (at most n).
+ * @note Space Complexity: O(m) for the reversed pattern and its LPS array.
+ */
+size_t KMPSearchLast(string_view text, string_view pattern) {
+    size_t n = text.length();
+    int m = pattern.length();
+    if (m == 0 || size_t(m) > n) {
+        return string::npos;
+    }
+    string reversed(pattern.rbegin(), pattern.rend());
+    vector<int> lps_reversed = computeLPS(reversed);
+    int j = 0; // length of the matched prefix of the reversed pattern
+    for (size_t i = n; i-- > 0;) {
+        while (j > 0 && reversed[j] != text[i]) {
+            j = lps_reversed[j - 1];
+        }
+        if (reversed[j] == text[i]) {
+            j++;
+        }
+        if (j == m) {
+            return i;
+        }
+    }
+    return string::npos;
+}
+
+/**
+ * @brief Dense match set storing one bit per text position.
+ *
+ * Bit i of words[i / 64] is set when position i is a match position. Unused bits of the last
+ * word are always zero, so whole-word operations (popcount, AND/OR of bitmaps) need no masking.
+ */
+struct MatchBitmap {
+    size_t size = 0;        // number of text positions covered
+    vector<uint64_t> words; // ceil(size / 64) words
+
+    bool test(size_t i) const {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+};
+
+/**
+ * @brief Counts the match positions in a bitmap.
+ *
+ * @param bitmap The bitmap to count.
+ * @return The number of set bits.
+ * @note Time Complexity: O(n / 64), one popcount per word.
+ */
+size_t countMatches(const MatchBitmap& bitmap) {
+    size_t count = 0;
+    for (uint64_t word : bitmap.words) {
+        count += popcount(word);
+    }
+    return count;
+}
+
+/**
+ * @brief Calls f(position) for every match position in a bitmap, in increasing order.
+ *
+ * Empty words are skipped whole and set bits are found with count-trailing-zeros, so the cost
+ * depends on the number of matches rather than on the number of text positions.
+ *
+ * @param bitmap The bitmap to iterate.
+ * @param f Callable invoked with each set position as a size_t.
+ */
+template <class F>
+void forEachMatch(const MatchBitmap& bitmap, F&& f) {
+    for (size_t w = 0; w < bitmap.words.size(); ++w) {
+        uint64_t word = bitmap.words[w];
+        while (word != 0) {
+            f(w * 64 + countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+/**
+ * @brief Runs the KMP search and records only where full matches end, one bit per text position.
+ *
+ * Bit i is set exactly when KMPSearch(text, pattern)[i] == pattern.length(), i.e. an occurrence of
+ * the pattern ends at text[i]; it starts at i - m + 1. Bits are accumulated in a register and
+ * each 64-bit word is stored once, so the output is 32x smaller than the per-position array.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @return A MatchBitmap of text.length() bits; all zero if the pattern is empty.
+ *
+ * @note Time Complexity: O(n + m), where n is the length of the text and m is the length of the pattern.
+ * @note Space Complexity: O(m + n / 64).
+ */
+MatchBitmap KMPSearchBitmap(string_view text, string_view pattern) {
+    size_t n = text.length();
+    int m = pattern.length();
+    MatchBitmap bitmap;
+    bitmap.size = n;
+    bitmap.words.assign((n + 63) / 64, 0);
+    if (m == 0) {
+        return bitmap;
+    }
     vector<int> lps_pattern = computeLPS(pattern);
-    vector<int> lps(n);
-    int i = 0; // index for text
+    uint64_t word = 0;
     int j = 0; // index for pattern
-    while (i < n) {
+    for (size_t i = 0; i < n; ++i) {
+        while (j > 0 && pattern[j] != text[i]) {
+            j = lps_pattern[j - 1];
+        }
         if (pattern[j] == text[i]) {
             j++;
-            lps[i] = j;
-            i++;
         }
-        if (j == m) {
-            j = lps_pattern[j - 1];
-        } else if (i < n && pattern[j] != text[i]) {
-            if (j != 0) {
-                j = lps_pattern[j - 1];
-            } else {
-                lps[i] = 0;
-                i++;
-            }
+        if (j == m) {
+            word |= uint64_t(1) << (i & 63);
+            j = lps_pattern[j - 1];
+        }
+        if ((i & 63) == 63) {
+            bitmap.words[i >> 6] = word;
+            word = 0;
+        }
+    }
+    if ((n & 63) != 0) {
+        bitmap.words[n >> 6] = word;
+    }
+    return bitmap;
+}
+
+/**
+ * @brief Sorted set of match offsets stored with the Elias-Fano encoding.
+ *
+ * Each value is split into `low_bits` low bits, stored packed, and a high part, stored in unary
+ * in a bit vector (element k sets bit (value >> low_bits) + k). With low_bits close to
+ * log2(universe / count) this takes about 2 + log2(universe / count) bits per value instead of 64.
+ * Values are appended in non-decreasing order, so the set can be filled while scanning.
+ * Every kSelectSample-th element records the position of its high bit, which bounds the scan of select().
+ */
+class EliasFanoMatches {
+public:
+    static constexpr size_t kSelectSample = 256;
+
+    class const_iterator {
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = ptrdiff_t;
+        using pointer = const uint64_t*;
+        using reference = uint64_t;
+
+        const_iterator() = default;
+        uint64_t operator*() const { return value_; }
+        const_iterator& operator++() {
+            ++k_;
+            advance();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+        bool operator==(const const_iterator& other) const { return k_ == other.k_; }
+
+    private:
+        friend class EliasFanoMatches;
+        const_iterator(const EliasFanoMatches* set, size_t k) : set_(set), k_(k) {
+            if (k_ < set_->size_) {
+                word_ = set_->high_[0];
+                advance();
+            }
+        }
+        void advance() {
+            if (k_ >= set_->size_) {
+                return;
+            }
+            while (word_ == 0) {
+                word_ = set_->high_[++word_index_];
+            }
+            uint64_t position = word_index_ * 64 + countr_zero(word_);
+            word_ &= word_ - 1;
+            value_ = ((position - k_) << set_->low_bits_) | set_->lowBits(k_);
+        }
+
+        const EliasFanoMatches* set_ = nullptr;
+        size_t k_ = 0;
+        size_t word_index_ = 0;
+        uint64_t word_ = 0;
+        uint64_t value_ = 0;
+    };
+
+    /**
+     * @param universe Exclusive upper bound of the values (e.g. the text length).
+     * @param expected_count Expected number of values, used only to pick low_bits.
+     */
+    explicit EliasFanoMatches(uint64_t universe = 0, size_t expected_count = 0) : universe_(universe) {
+        if (expected_count > 0 && universe > expected_count) {
+            low_bits_ = bit_width(universe / expected_count) - 1;
+        }
+    }
+
+    /**
+     * @brief Appends a value; it must be >= the previously appended value.
+     */
+    void push_back(uint64_t value) {
+        assert(size_ == 0 || value >= last_);
+        size_t low_position = size_ * low_bits_;
+        if (low_bits_ > 0) {
+            if ((low_position + low_bits_ + 63) / 64 > low_.size()) {
+                low_.push_back(0);
+            }
+            uint64_t low = value & ((uint64_t(1) << low_bits_) - 1);
+            low_[low_position / 64] |= low << (low_position % 64);
+            if (low_position % 64 + low_bits_ > 64) {
+                low_[low_position / 64 + 1] |= low >> (64 - low_position % 64);
+            }
+        }
+        uint64_t high_position = (value >> low_bits_) + size_;
+        if (high_position / 64 >= high_.size()) {
+            high_.resize(high_position / 64 + 1, 0);
+        }
+        high_[high_position / 64] |= uint64_t(1) << (high_position % 64);
+        if (size_ % kSelectSample == 0) {
+            select_samples_.push_back(high_position);
+        }
+        last_ = value;
+        universe_ = max(universe_, value + 1);
+        size_++;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    uint64_t universe() const { return universe_; }
+    int lowBits() const { return low_bits_; }
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size_); }
+
+    /**
+     * @brief Returns the k-th smallest value (0-based). Requires k < size().
+     */
+    uint64_t select(size_t k) const {
+        assert(k < size_);
+        // Start from the sampled element at or before k; its own bit is the 0th one counted.
+        uint64_t sample_position = select_samples_[k / kSelectSample];
+        size_t remaining = k % kSelectSample;
+        size_t word_index = sample_position / 64;
+        uint64_t word = high_[word_index] & (~uint64_t(0) << (sample_position % 64));
+        while (true) {
+            size_t ones = popcount(word);
+            if (remaining < ones) {
+                break;
+            }
+            remaining -= ones;
+            word = high_[++word_index];
+        }
+        for (size_t r = 0; r < remaining; ++r) {
+            word &= word - 1;
+        }
+        uint64_t position = word_index * 64 + countr_zero(word);
+        return ((position - k) << low_bits_) | lowBits(k);
+    }
+
+    /**
+     * @brief Returns the number of values strictly less than value.
+     */
+    size_t rank(uint64_t value) const {
+        size_t lo = 0, hi = size_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (select(mid) < value) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /**
+     * @brief Returns the size of the encoding in bytes.
+     */
+    size_t memoryBytes() const {
+        return (low_.size() + high_.size() + select_samples_.size()) * sizeof(uint64_t);
+    }
+
+    /**
+     * @brief Merges two sets (e.g. the results of two parallel shards) into one sorted set.
+     *
+     * Values present in both inputs, such as matches found twice in overlapping shard borders,
+     * are kept once.
+     */
+    static EliasFanoMatches merge(const EliasFanoMatches& a, const EliasFanoMatches& b) {
+        EliasFanoMatches merged(max(a.universe_, b.universe_), a.size_ + b.size_);
+        const_iterator it_a = a.begin(), it_b = b.begin();
+        while (it_a != a.end() || it_b != b.end()) {
+            uint64_t value;
+            if (it_b == b.end() || (it_a != a.end() && *it_a <= *it_b)) {
+                value = *it_a++;
+            } else {
+                value = *it_b++;
+            }
+            if (merged.empty() || value != merged.last_) {
+                merged.push_back(value);
+            }
+        }
+        return merged;
+    }
+
+private:
+    uint64_t lowBits(size_t k) const {
+        if (low_bits_ == 0) {
+            return 0;
+        }
+        size_t position = k * low_bits_;
+        uint64_t low = low_[position / 64] >> (position % 64);
+        if (position % 64 + low_bits_ > 64) {
+            low |= low_[position / 64 + 1] << (64 - position % 64);
+        }
+        return low & ((uint64_t(1) << low_bits_) - 1);
+    }
+
+    int low_bits_ = 0;
+    size_t size_ = 0;
+    uint64_t universe_ = 0;
+    uint64_t last_ = 0;
+    vector<uint64_t> low_;
+    vector<uint64_t> high_;
+    vector<uint64_t> select_samples_; // high-bit position of every kSelectSample-th element
+};
+
+/**
+ * @brief Runs the KMP search and collects the starting offsets of all matches as an Elias-Fano set.
+ *
+ * Offsets are appended to the encoding as matches are found, so the full hit set of a dense
+ * pattern is kept at a few bits per match and no intermediate vector is built.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @param expected_count Expected number of matches, used to size the low bits; 0 uses the upper
+ *        bound n / period(pattern), which is exact for highly periodic dense patterns.
+ * @return The set of starting offsets of all (possibly overlapping) occurrences.
+ *
+ * @note Time Complexity: O(n + m).
+ * @note Space Complexity: O(m) plus about 2 + log2(n / count) bits per match.
+ */
+EliasFanoMatches KMPSearchEliasFano(string_view text, string_view pattern, size_t expected_count = 0) {
+    size_t n = text.length();
+    int m = pattern.length();
+    if (m == 0) {
+        return EliasFanoMatches(n);
+    }
+    vector<int> lps_pattern = computeLPS(pattern);
+    if (expected_count == 0) {
+        int period = m - lps_pattern[m - 1];
+        expected_count = n / period + 1;
+    }
+    EliasFanoMatches matches(n, expected_count);
+    int j = 0; // index for pattern
+    for (size_t i = 0; i < n; ++i) {
+        while (j > 0 && pattern[j] != text[i]) {
+            j = lps_pattern[j - 1];
+        }
+        if (pattern[j] == text[i]) {
+            j++;
+        }
+        if (j == m) {
+            matches.push_back(i - m + 1);
+            j = lps_pattern[j - 1];
+        }
+    }
+    return matches;
+}
+
+/**
+ * @brief Per-position integer profile compressed into arithmetic runs.
+ *
+ * The profile is stored as runs of the form first, first + step, first + 2 * step, ...;
+ * runs of zeros (step 0) and the ramps 1, 2, 3, ... (step 1) that make up most LPS / Z outputs
+ * both collapse to a single run. Values are appended in order and read back by position.
+ */
+class RunLengthProfile {
+public:
+    /**
+     * @brief Appends the value of the next position.
+     */
+    void push_back(int value) {
+        if (!runs_.empty()) {
+            Run& last = runs_.back();
+            size_t length = size_ - last.start;
+            if (length == 1) {
+                last.step = value - last.first;
+                size_++;
+                return;
+            }
+            if (last.first + last.step * (int)length == value) {
+                size_++;
+                return;
+            }
+        }
+        runs_.push_back({size_, value, 0});
+        size_++;
+    }
+
+    /**
+     * @brief Returns the value at position i in O(log r), where r is the number of runs.
+     */
+    int operator[](size_t i) const {
+        assert(i < size_);
+        auto it = upper_bound(runs_.begin(), runs_.end(), i,
+                              [](size_t position, const Run& run) { return position < run.start; });
+        const Run& run = *(it - 1);
+        return run.first + run.step * (int)(i - run.start);
+    }
+
+    size_t size() const { return size_; }
+    size_t runCount() const { return runs_.size(); }
+    size_t memoryBytes() const { return runs_.size() * sizeof(Run); }
+
+    /**
+     * @brief Decompresses the whole profile.
+     */
+    vector<int> expand() const {
+        vector<int> values;
+        values.reserve(size_);
+        for (size_t r = 0; r < runs_.size(); ++r) {
+            size_t end = r + 1 < runs_.size() ? runs_[r + 1].start : size_;
+            for (size_t i = runs_[r].start; i < end; ++i) {
+                values.push_back(runs_[r].first + runs_[r].step * (int)(i - runs_[r].start));
+            }
+        }
+        return values;
+    }
+
+private:
+    struct Run {
+        size_t start; // first position covered by the run
+        int first;    // value at start
+        int step;     // difference between consecutive values
+    };
+
+    vector<Run> runs_;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Runs the KMP search and returns the per-position LPS state array in run-length form.
+ *
+ * The result holds the same values as KMPSearch(text, pattern) but is built directly while
+ * scanning, so the full n-entry array is never materialized.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @return The compressed profile; empty if the pattern is empty.
+ *
+ * @note Time Complexity: O(n + m).
+ * @note Space Complexity: O(m + r), where r is the number of runs in the profile.
+ */
+RunLengthProfile KMPSearchRunLength(string_view text, string_view pattern) {
+    size_t n = text.length();
+    int m = pattern.length();
+    RunLengthProfile profile;
+    if (m == 0) {
+        return profile;
+    }
+    vector<int> lps_pattern = computeLPS(pattern);
+    int j = 0; // index for pattern
+    for (size_t i = 0; i < n; ++i) {
+        if (j == m) {
+            j = lps_pattern[j - 1];
+        }
+        while (j > 0 && pattern[j] != text[i]) {
+            j = lps_pattern[j - 1];
+        }
+        if (pattern[j] == text[i]) {
+            j++;
+        }
+        profile.push_back(j);
+    }
+    return profile;
+}
+
+/**
+ * @brief Growable scratch buffers reused across searches.
+ *
+ * A workspace holds the pattern table and the per-position output of a search. Buffers only grow
+ * while they are too small, so once a thread has seen its largest request, further searches
+ * allocate nothing. The largest request since the last trim (the high-water mark) is tracked,
+ * and every trim_interval searches any buffer larger than that mark (and min_capacity) is
+ * shrunk back, so a single huge request does not pin memory forever. A search calls
+ * beginSearch() before taking any buffer: trimming only happens there, so the spans a search
+ * holds stay valid until the next search starts.
+ */
+class SearchWorkspace {
+public:
+    struct TrimPolicy {
+        size_t trim_interval = 1024; // searches between trims; 0 disables trimming
+        size_t min_capacity = 4096;  // elements a buffer is never trimmed below
+    };
+
+    SearchWorkspace() = default;
+    explicit SearchWorkspace(TrimPolicy policy) : policy_(policy) {}
+
+    /**
+     * @brief Starts a search, trimming first if trim_interval searches ran since the last trim.
+     */
+    void beginSearch() {
+        if (policy_.trim_interval != 0 && searches_ >= policy_.trim_interval) {
+            trim();
+        }
+        searches_++;
+    }
+
+    /**
+     * @brief Returns a pattern table buffer of the given size.
+     */
+    span<int> patternTable(size_t size) {
+        return acquire(pattern_table_, size);
+    }
+
+    /**
+     * @brief Returns an output buffer of the given size.
+     */
+    span<int> output(size_t size) {
+        return acquire(output_, size);
+    }
+
+    /**
+     * @brief Shrinks every buffer to max(high-water mark, min_capacity) and starts a new window.
+     *
+     * Spans previously returned by patternTable() and output() may be invalidated.
+     */
+    void trim() {
+        size_t keep = max(high_water_, policy_.min_capacity);
+        for (vector<int>* buffer : {&pattern_table_, &output_}) {
+            if (buffer->size() > keep) {
+                vector<int>(keep).swap(*buffer);
+                allocations_++;
+            }
+        }
+        high_water_ = 0;
+        searches_ = 0;
+    }
+
+    size_t capacity() const { return pattern_table_.size() + output_.size(); }
+    size_t highWater() const { return high_water_; }
+    size_t allocations() const { return allocations_; }
+
+private:
+    span<int> acquire(vector<int>& buffer, size_t size) {
+        high_water_ = max(high_water_, size);
+        if (buffer.size() < size) {
+            buffer.resize(max(size, buffer.size() * 2));
+            allocations_++;
+        }
+        return span<int>(buffer.data(), size);
+    }
+
+    TrimPolicy policy_;
+    vector<int> pattern_table_;
+    vector<int> output_;
+    size_t high_water_ = 0;   // largest buffer requested since the last trim
+    size_t searches_ = 0;     // searches started since the last trim
+    size_t allocations_ = 0;  // number of times a buffer was (re)allocated
+};
+
+/**
+ * @brief Returns the calling thread's search workspace.
+ */
+SearchWorkspace& threadLocalSearchWorkspace() {
+    thread_local SearchWorkspace workspace;
+    return workspace;
+}
+
+/**
+ * @brief Runs the KMP search using the buffers of a workspace.
+ *
+ * @param workspace The workspace providing the pattern table and output buffers.
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @return The same values as KMPSearch(text, pattern), as a view of the workspace's output
+ *         buffer. The view is valid until the next search using the same workspace.
+ *
+ * @note Time Complexity: O(n + m).
+ * @note Space Complexity: O(n + m), allocated only when the workspace has to grow.
+ */
+span<const int> KMPSearch(SearchWorkspace& workspace, string_view text, string_view pattern) {
+    workspace.beginSearch();
+    if (pattern.empty()) {
+        return {};
+    }
+    span<int> lps_pattern = workspace.patternTable(pattern.length());
+    span<int> lps = workspace.output(text.length());
+    KMPSearch(text, pattern, lps_pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief Returns the best wall-clock time of f over a number of repetitions, in milliseconds.
+ */
+template <class F>
+double measureMilliseconds(F&& f, int repetitions = 3) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief Returns a pseudo-random string of the given length over the first `alphabet` letters.
+ */
+string randomText(size_t length, int alphabet, uint64_t seed = 1) {
+    mt19937_64 generator(seed);
+    string text(length, 'a');
+    for (char& c : text) {
+        c = 'a' + generator() % alphabet;
+    }
+    return text;
+}
+
+/**
+ * @brief One pattern position of a compiled pattern: the pattern byte and its failure link.
+ *
+ * Record j holds pattern[j] and lps[j - 1], the state to fall back to on a mismatch at j, so a
+ * search step reads a single record instead of two separate arrays. Record m is a sentinel
+ * whose failure link, lps[m - 1], is taken after a full match.
+ */
+template <class Link>
+struct PatternRecord {
+    Link failure_link;
+    char pattern_byte;
+
+    char byte() const { return pattern_byte; }
+    int failure() const { return failure_link; }
+    void set(char b, int failure) {
+        pattern_byte = b;
+        failure_link = failure;
+    }
+};
+
+/**
+ * @brief A PatternRecord packed into 32 bits: the byte in the low 8 bits, a 24-bit link above.
+ *
+ * A struct of a 4-byte link and a byte pads to 8 bytes, more than the 4 + 1 bytes of separate
+ * arrays; packing makes the interleaved table the smaller one.
+ */
+struct PackedPatternRecord {
+    static constexpr int kMaxLink = (1 << 24) - 1;
+
+    uint32_t bits;
+
+    char byte() const { return char(bits & 0xff); }
+    int failure() const { return int(bits >> 8); }
+    void set(char b, int failure) { bits = uint32_t(failure) << 8 | (unsigned char)b; }
+};
+
+/**
+ * @brief A pattern preprocessed once for repeated KMP searches.
+ *
+ * The pattern is stored as an array of pattern records, interleaving each pattern byte with its
+ * failure link. Patterns of up to kInlineCapacity bytes use 2-byte records held inline in a
+ * 64-byte aligned block, so searching a short pattern needs no heap allocation and no pointer
+ * chase, and patterns of up to 31 bytes fit in a single cache line. Longer patterns use 4-byte
+ * PackedPatternRecords on the heap, and patterns whose links do not fit in 24 bits 8-byte
+ * records.
+ */
+class CompiledPattern {
+public:
+    static constexpr int kInlineCapacity = 64;
+
+    explicit CompiledPattern(string_view pattern) : length_(pattern.length()) {
+        if (length_ == 0) {
+            return;
+        }
+        vector<int> lps = computeLPS(pattern);
+        if (length_ <= kInlineCapacity) {
+            fillRecords(pattern, lps, inline_records_);
+        } else if (isPacked()) {
+            packed_records_.resize(length_ + 1);
+            fillRecords(pattern, lps, packed_records_.data());
+        } else {
+            wide_records_.resize(length_ + 1);
+            fillRecords(pattern, lps, wide_records_.data());
+        }
+    }
+
+    int length() const { return length_; }
+    bool isInline() const { return length_ <= kInlineCapacity; }
+    bool isPacked() const { return !isInline() && length_ <= PackedPatternRecord::kMaxLink; }
+
+    /**
+     * @brief Calls f(records) with a pointer to the length() + 1 pattern records.
+     *
+     * The records are PatternRecord<uint8_t> for inline patterns, PackedPatternRecord for
+     * packed ones and PatternRecord<int32_t> otherwise, so f is usually a generic lambda.
+     */
+    template <class F>
+    decltype(auto) visit(F&& f) const {
+        if (isInline()) {
+            return f(static_cast<const PatternRecord<uint8_t>*>(inline_records_));
+        }
+        if (isPacked()) {
+            return f(static_cast<const PackedPatternRecord*>(packed_records_.data()));
+        }
+        return f(static_cast<const PatternRecord<int32_t>*>(wide_records_.data()));
+    }
+
+private:
+    template <class Record>
+    static void fillRecords(string_view pattern, const vector<int>& lps, Record* records) {
+        int m = pattern.length();
+        for (int j = 0; j <= m; ++j) {
+            records[j].set(j < m ? pattern[j] : 0, j > 0 ? lps[j - 1] : 0);
+        }
+    }
+
+    alignas(64) PatternRecord<uint8_t> inline_records_[kInlineCapacity + 1];
+    int length_;
+    vector<PackedPatternRecord> packed_records_;
+    vector<PatternRecord<int32_t>> wide_records_;
+};
+
+/**
+ * @brief Runs the KMP search loop against an interleaved record array over text[begin, end).
+ *
+ * @param j The pattern state before text[begin].
+ * @return The pattern state after text[end - 1], to continue from at end.
+ */
+template <class Record>
+int KMPSearchWithRecords(string_view text, const Record* records, int m, span<int> lps, size_t begin, size_t end,
+                         int j) {
+    size_t i = begin; // index for text
+    while (i < end) {
+        if (records[j].byte() == text[i]) {
+            j++;
+            lps[i] = j;
+            i++;
+        }
+        if (j == m) {
+            j = records[m].failure();
+        } else if (i < end && records[j].byte() != text[i]) {
+            if (j != 0) {
+                j = records[j].failure();
+            } else {
+                lps[i] = 0;
+                i++;
+            }
+        }
+    }
+    return j;
+}
+
+/**
+ * @brief Runs the KMP search with a compiled pattern, writing into a caller-provided buffer.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The compiled pattern to search for.
+ * @param lps Output buffer; at least text.length() elements. Receives the same values as
+ *            KMPSearch(text, pattern string). Nothing is written if the pattern is empty.
+ *
+ * @note Time Complexity: O(n), the pattern having been preprocessed already.
+ * @note Space Complexity: O(1) beyond the output buffer.
+ */
+void KMPSearch(string_view text, const CompiledPattern& pattern, span<int> lps) {
+    assert(lps.size() >= text.length());
+    if (pattern.length() == 0) {
+        return;
+    }
+    pattern.visit([&](const auto* records) {
+        KMPSearchWithRecords(text, records, pattern.length(), lps, 0, text.length(), 0);
+    });
+}
+
+/**
+ * @brief Runs the KMP search with a compiled pattern.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The compiled pattern to search for.
+ * @return The same values as KMPSearch(text, pattern string).
+ *
+ * @note Time Complexity: O(n).
+ * @note Space Complexity: O(n) for the result.
+ */
+vector<int> KMPSearch(string_view text, const CompiledPattern& pattern) {
+    if (pattern.length() == 0) {
+        return {};
+    }
+    vector<int> lps(text.length());
+    KMPSearch(text, pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief LPS array of a huge pattern, delta-encoded with sampled checkpoints.
+ *
+ * Since lps[i] <= lps[i - 1] + 1, each entry is stored as the one-byte drop
+ * d[i] = lps[i - 1] + 1 - lps[i] (0 along ramps), with drops of 255 or more moved to an escape
+ * list. Every kCheckpointInterval-th entry is stored in full, and an entry is decoded by summing
+ * the drops since its checkpoint. This takes about 1.25 bytes per pattern byte instead of 4, so
+ * four times more of the table stays in cache during fallbacks.
+ */
+class CompressedLPS {
+public:
+    static constexpr int kCheckpointInterval = 32;
+    static constexpr uint8_t kEscape = 255;
+
+    /**
+     * @brief Builds the table; computeLPS(pattern) is materialized temporarily while building.
+     */
+    explicit CompressedLPS(string_view pattern) : size_(pattern.length()) {
+        vector<int> lps = computeLPS(pattern);
+        size_t blocks = (size_ + kCheckpointInterval - 1) / kCheckpointInterval;
+        checkpoints_.resize(blocks);
+        escape_begin_.resize(blocks);
+        drops_.resize(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            if (i % kCheckpointInterval == 0) {
+                checkpoints_[i / kCheckpointInterval] = lps[i];
+                escape_begin_[i / kCheckpointInterval] = escapes_.size();
+                drops_[i] = 0;
+                continue;
+            }
+            int drop = lps[i - 1] + 1 - lps[i];
+            if (drop >= kEscape) {
+                drops_[i] = kEscape;
+                escapes_.push_back(drop);
+            } else {
+                drops_[i] = drop;
+            }
+        }
+    }
+
+    /**
+     * @brief Returns lps[i], decoding at most kCheckpointInterval - 1 drops.
+     */
+    int operator[](size_t i) const {
+        size_t block = i / kCheckpointInterval;
+        int value = checkpoints_[block];
+        const uint8_t* drop = drops_.data() + block * kCheckpointInterval;
+        const int32_t* escape = escapes_.data() + escape_begin_[block];
+        for (size_t t = 1; t <= i % kCheckpointInterval; ++t) {
+            value += 1 - (drop[t] == kEscape ? *escape++ : drop[t]);
+        }
+        return value;
+    }
+
+    size_t size() const { return size_; }
+
+    size_t memoryBytes() const {
+        return drops_.size() + checkpoints_.size() * sizeof(int32_t) +
+               escape_begin_.size() * sizeof(uint32_t) + escapes_.size() * sizeof(int32_t);
+    }
+
+private:
+    size_t size_;
+    vector<uint8_t> drops_;         // d[i], or kEscape if the drop is in escapes_
+    vector<int32_t> checkpoints_;   // lps[b * kCheckpointInterval]
+    vector<uint32_t> escape_begin_; // first escape of each checkpoint block
+    vector<int32_t> escapes_;       // drops >= kEscape, in position order
+};
+
+/**
+ * @brief Runs the KMP search for a huge pattern using its compressed LPS table.
+ *
+ * Each failure link depends on the one decoded before it, so fallbacks are not prefetched:
+ * prefetching the block of the current or the next link measured no faster than this loop.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @param lps_pattern The compressed LPS table of pattern.
+ * @return The starting offsets of all (possibly overlapping) occurrences, in increasing order.
+ *
+ * @note Time Complexity: O(n * kCheckpointInterval) worst case, O(n) when fallbacks are rare.
+ * @note Space Complexity: O(k) for k matches, beyond the compressed table.
+ */
+vector<size_t> KMPSearchHuge(string_view text, string_view pattern, const CompressedLPS& lps_pattern) {
+    size_t n = text.length();
+    int m = pattern.length();
+    vector<size_t> matches;
+    if (m == 0) {
+        return matches;
+    }
+    assert(lps_pattern.size() == (size_t)m);
+    int j = 0; // index for pattern
+    for (size_t i = 0; i < n; ++i) {
+        while (j > 0 && pattern[j] != text[i]) {
+            j = lps_pattern[j - 1];
+        }
+        if (pattern[j] == text[i]) {
+            j++;
+        }
+        if (j == m) {
+            matches.push_back(i - m + 1);
+            j = lps_pattern[j - 1];
+        }
+    }
+    return matches;
+}
+
+enum class HugePageMode {
+    Transparent, // madvise(MADV_HUGEPAGE) on a 2 MiB aligned anonymous mapping
+    Explicit,    // MAP_HUGETLB from the reserved huge page pool, falling back to Transparent
+};
+
+/**
+ * @brief Asks the kernel to back a range of memory with transparent huge pages.
+ *
+ * Useful for mmap'd inputs and other large buffers not allocated with HugePageAllocator.
+ *
+ * @return true if the advice was accepted (always false on non-Linux systems).
+ */
+bool adviseHugePages(void* address, size_t length) {
+#ifdef __linux__
+    uintptr_t begin = reinterpret_cast<uintptr_t>(address) & ~uintptr_t(4095);
+    uintptr_t end = reinterpret_cast<uintptr_t>(address) + length;
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void)address;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * @brief Allocator placing large buffers (result arrays, index structures) on huge pages.
+ *
+ * Allocations of at least kHugePageSize bytes get their own 2 MiB aligned mapping, backed by
+ * huge pages according to the mode, which cuts dTLB misses when scanning them. Smaller
+ * allocations, and all allocations on non-Linux systems, use operator new.
+ */
+template <class T>
+class HugePageAllocator {
+public:
+    using value_type = T;
+    static constexpr size_t kHugePageSize = size_t(2) << 20;
+
+    HugePageAllocator() = default;
+    explicit HugePageAllocator(HugePageMode mode) : mode_(mode) {}
+    template <class U>
+    HugePageAllocator(const HugePageAllocator<U>& other) : mode_(other.mode()) {}
+
+    HugePageMode mode() const { return mode_; }
+
+    T* allocate(size_t count) {
+        size_t bytes = count * sizeof(T);
+#ifdef __linux__
+        if (bytes >= kHugePageSize) {
+            size_t rounded = roundUp(bytes);
+            if (mode_ == HugePageMode::Explicit) {
+                void* address = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (address != MAP_FAILED) {
+                    return static_cast<T*>(address);
+                }
+            }
+            // Over-map by one huge page and unmap the unaligned head and tail.
+            void* raw = mmap(nullptr, rounded + kHugePageSize, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED) {
+                throw bad_alloc();
+            }
+            uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = (begin + kHugePageSize - 1) & ~(kHugePageSize - 1);
+            if (aligned != begin) {
+                munmap(raw, aligned - begin);
+            }
+            munmap(reinterpret_cast<void*>(aligned + rounded), begin + kHugePageSize - aligned);
+            adviseHugePages(reinterpret_cast<void*>(aligned), rounded);
+            return reinterpret_cast<T*>(aligned);
+        }
+#endif
+        return static_cast<T*>(::operator new(bytes));
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        size_t bytes = count * sizeof(T);
+#ifdef __linux__
+        if (bytes >= kHugePageSize) {
+            munmap(pointer, roundUp(bytes));
+            return;
+        }
+#endif
+        ::operator delete(pointer);
+    }
+
+    template <class U>
+    bool operator==(const HugePageAllocator<U>& other) const { return mode_ == other.mode(); }
+
+private:
+    static size_t roundUp(size_t bytes) {
+        return (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    }
+
+    HugePageMode mode_ = HugePageMode::Transparent;
+};
+
+template <class T>
+using HugePageVector = vector<T, HugePageAllocator<T>>;
+
+/**
+ * @brief Runs the KMP search with the result array allocated on huge pages.
+ *
+ * @param text The main text string to search within.
+ * @param pattern The pattern string to search for.
+ * @param allocator The allocator for the result, selecting the huge page mode.
+ * @return The same values as KMPSearch(text, pattern).
+ */
+HugePageVector<int> KMPSearch(string_view text, string_view pattern, HugePageAllocator<int> allocator) {
+    int m = pattern.length();
+    if (m == 0) {
+        return HugePageVector<int>(allocator);
+    }
+    vector<int> lps_pattern(m);
+    HugePageVector<int> lps(text.length(), allocator);
+    KMPSearch(text, pattern, lps_pattern, lps);
+    return lps;
+}
+
+/**
+ * @brief Lazy input range over the starting offsets of all matches of a pattern in a text.
+ *
+ * Only the pattern's LPS table is computed up front; the KMP state lives in the iterator, so no
+ * result buffer is built. Iterators are lazy: an increment only marks the current match as used,
+ * and the scan to the next match runs when the iterator is dereferenced or compared with the
+ * end. Consumers that stop early (e.g. through views::take, which increments past the last
+ * element it yields) therefore never scan beyond the last match they read. The table is shared,
+ * making copies of the view O(1). The text must outlive the view and its iterators.
+ */
+class KMPMatchView : public ranges::view_interface<KMPMatchView> {
+public:
+    class iterator {
+    public:
+        using iterator_concept = input_iterator_tag;
+        using value_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        iterator() = default;
+
+        size_t operator*() const {
+            settle();
+            return match_;
+        }
+
+        iterator& operator++() {
+            stale_ = true;
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        bool operator==(default_sentinel_t) const {
+            settle();
+            return done_;
+        }
+
+        /**
+         * @brief Returns the number of text bytes scanned so far.
+         */
+        size_t consumed() const { return i_; }
+
+    private:
+        friend class KMPMatchView;
+
+        iterator(string_view text, string_view pattern, const int* lps_pattern)
+            : text_(text), pattern_(pattern), lps_pattern_(lps_pattern), done_(false), stale_(true) {}
+
+        void settle() const {
+            if (stale_) {
+                stale_ = false;
+                findNext();
+            }
+        }
+
+        void findNext() const {
+            int n = text_.length();
+            int m = pattern_.length();
+            if (m == 0) {
+                done_ = true;
+                return;
+            }
+            while (i_ < n) {
+                while (j_ > 0 && pattern_[j_] != text_[i_]) {
+                    j_ = lps_pattern_[j_ - 1];
+                }
+                if (pattern_[j_] == text_[i_]) {
+                    j_++;
+                }
+                i_++;
+                if (j_ == m) {
+                    match_ = i_ - m;
+                    j_ = lps_pattern_[j_ - 1];
+                    return;
+                }
+            }
+            done_ = true;
+        }
+
+        string_view text_;
+        string_view pattern_;
+        const int* lps_pattern_ = nullptr;
+        // Scan state, advanced on demand by the const accessors.
+        mutable int i_ = 0; // next text position to consume
+        mutable int j_ = 0; // matched pattern prefix length
+        mutable size_t match_ = 0;
+        mutable bool done_ = true;
+        mutable bool stale_ = false; // match_ has been used; the next one is not searched yet
+    };
+
+    KMPMatchView() = default;
+
+    KMPMatchView(string_view text, string_view pattern)
+        : text_(text), pattern_(pattern), lps_pattern_(make_shared<const vector<int>>(computeLPS(pattern))) {}
+
+    iterator begin() const { return iterator(text_, pattern_, lps_pattern_->data()); }
+    default_sentinel_t end() const { return default_sentinel; }
+
+private:
+    string_view text_;
+    string_view pattern_;
+    shared_ptr<const vector<int>> lps_pattern_ = make_shared<const vector<int>>();
+};
+
+/**
+ * @brief Returns a lazy range of the starting offsets of all (possibly overlapping) matches.
+ *
+ * The range composes with standard views, e.g. kmp_matches(text, pattern) | views::take(3).
+ *
+ * @param text The main text to search within; it must outlive the returned view.
+ * @param pattern The pattern to search for; it must outlive the returned view.
+ * @return A KMPMatchView producing offsets in increasing order; empty if the pattern is empty.
+ *
+ * @note Time Complexity: O(m) to construct, O(n + m) in total over a full iteration.
+ * @note Space Complexity: O(m).
+ */
+KMPMatchView kmp_matches(string_view text, string_view pattern) {
+    return KMPMatchView(text, pattern);
+}
+
+/**
+ * @brief KMP matcher over a stream of chunks.
+ *
+ * The matcher keeps the pattern, its LPS table and the current pattern state, so a text can be
+ * fed in arbitrary pieces and matches spanning chunk boundaries are still found. Offsets are
+ * counted from the start of the stream.
+ */
+class KMPStreamMatcher {
+public:
+    explicit KMPStreamMatcher(string_view pattern) : pattern_(pattern), lps_pattern_(computeLPS(pattern)) {}
+
+    /**
+     * @brief Consumes one character; returns true if a match ends at it.
+     *
+     * The match then starts at consumed() - patternLength().
+     */
+    bool step(char c) {
+        int m = pattern_.length();
+        consumed_++;
+        if (m == 0) {
+            return false;
+        }
+        while (j_ > 0 && pattern_[j_] != c) {
+            j_ = lps_pattern_[j_ - 1];
+        }
+        if (pattern_[j_] == c) {
+            j_++;
+        }
+        if (j_ == m) {
+            j_ = lps_pattern_[j_ - 1];
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Consumes a chunk, calling on_match(offset) with the stream offset of each match start.
+     */
+    template <class F>
+    void feed(string_view chunk, F&& on_match) {
+        for (char c : chunk) {
+            if (step(c)) {
+                on_match(consumed_ - pattern_.length());
+            }
+        }
+    }
+
+    size_t consumed() const { return consumed_; }
+    size_t patternLength() const { return pattern_.length(); }
+    int state() const { return j_; }
+
+    /**
+     * @brief Restores a state saved from state() and consumed(), e.g. to resume a scan.
+     */
+    void restore(int state, size_t consumed) {
+        j_ = state;
+        consumed_ = consumed;
+    }
+
+private:
+    string pattern_;
+    vector<int> lps_pattern_;
+    int j_ = 0;           // matched pattern prefix length
+    size_t consumed_ = 0; // characters consumed so far
+};
+
+/**
+ * @brief Coroutine generator of match offsets.
+ *
+ * The generator is lazy: the coroutine body runs only while the consumer advances an iterator,
+ * and it is suspended between matches without needing a thread or stack of its own. It is a
+ * single-pass range: only the first begin() starts the coroutine, and later calls return an
+ * iterator at the current match instead of resuming it again.
+ */
+class MatchGenerator {
+public:
+    struct promise_type {
+        size_t current = 0;
+        exception_ptr exception;
+
+        MatchGenerator get_return_object() {
+            return MatchGenerator(coroutine_handle<promise_type>::from_promise(*this));
+        }
+        suspend_always initial_suspend() noexcept { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        suspend_always yield_value(size_t offset) noexcept {
+            current = offset;
+            return {};
+        }
+        void return_void() {}
+        void unhandled_exception() { exception = current_exception(); }
+    };
+
+    class iterator {
+    public:
+        using iterator_concept = input_iterator_tag;
+        using value_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        size_t operator*() const { return handle_.promise().current; }
+        iterator& operator++() {
+            resume(handle_);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(default_sentinel_t) const { return !handle_ || handle_.done(); }
+
+    private:
+        coroutine_handle<promise_type> handle_;
+    };
+
+    MatchGenerator(MatchGenerator&& other) noexcept
+        : handle_(exchange(other.handle_, {})), started_(exchange(other.started_, false)) {}
+    MatchGenerator& operator=(MatchGenerator&& other) noexcept {
+        if (this != &other) {
+            if (handle_) {
+                handle_.destroy();
+            }
+            handle_ = exchange(other.handle_, {});
+            started_ = exchange(other.started_, false);
+        }
+        return *this;
+    }
+    ~MatchGenerator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    iterator begin() {
+        // Resuming a started coroutine would skip a match, or run past its final suspend.
+        if (handle_ && !started_) {
+            started_ = true;
+            resume(handle_);
+        }
+        return iterator(handle_);
+    }
+    default_sentinel_t end() const { return default_sentinel; }
+
+private:
+    explicit MatchGenerator(coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    static void resume(coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.promise().exception) {
+            rethrow_exception(handle.promise().exception);
+        }
+    }
+
+    coroutine_handle<promise_type> handle_;
+    bool started_ = false; // begin() has run the coroutine to its first match
+};
+
+/**
+ * @brief Synchronous chunk source: returns the next chunk, or nullopt at end of input.
+ *
+ * The returned view only needs to stay valid until the next call.
+ */
+using ChunkReader = function<optional<string_view>()>;
+
+/**
+ * @brief Yields the stream offsets of all matches of a pattern in the chunks read from reader.
+ *
+ * @param reader The chunk source; chunks are read only as the generator is advanced.
+ * @param pattern The pattern to search for.
+ * @return A generator of match start offsets in increasing order.
+ */
+MatchGenerator kmpMatchGenerator(ChunkReader reader, string pattern) {
+    KMPStreamMatcher matcher(pattern);
+    while (optional<string_view> chunk = reader()) {
+        for (char c : *chunk) {
+            if (matcher.step(c)) {
+                co_yield matcher.consumed() - matcher.patternLength();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Single-threaded asynchronous chunk queue, e.g. filled by an I/O completion loop.
+ *
+ * A consumer coroutine awaits next(); push() and close() resume a suspended consumer inline.
+ * This is the reader abstraction expected by asyncKMPScan: any type whose next() returns an
+ * awaitable producing optional<string> can be used instead.
+ */
+class ChunkChannel {
+public:
+    struct NextAwaiter {
+        ChunkChannel* channel;
+
+        bool await_ready() const noexcept { return !channel->chunks_.empty() || channel->closed_; }
+        void await_suspend(coroutine_handle<> handle) noexcept { channel->waiter_ = handle; }
+        optional<string> await_resume() {
+            if (channel->chunks_.empty()) {
+                return nullopt;
+            }
+            string chunk = move(channel->chunks_.front());
+            channel->chunks_.pop_front();
+            return chunk;
+        }
+    };
+
+    NextAwaiter next() { return NextAwaiter{this}; }
+
+    void push(string chunk) {
+        chunks_.push_back(move(chunk));
+        wake();
+    }
+
+    void close() {
+        closed_ = true;
+        wake();
+    }
+
+private:
+    void wake() {
+        if (waiter_) {
+            exchange(waiter_, {}).resume();
+        }
+    }
+
+    deque<string> chunks_;
+    bool closed_ = false;
+    coroutine_handle<> waiter_;
+};
+
+/**
+ * @brief Handle of an eagerly started asynchronous scan.
+ *
+ * The scan runs until its first suspension when created and is resumed by its reader; done()
+ * reports whether it has consumed the whole input. Destroying the handle destroys the coroutine;
+ * a moved-from handle owns no scan and reports done().
+ */
+class ScanTask {
+public:
+    struct promise_type {
+        exception_ptr exception;
+
+        ScanTask get_return_object() { return ScanTask(coroutine_handle<promise_type>::from_promise(*this)); }
+        suspend_never initial_suspend() noexcept { return {}; }
+        suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = current_exception(); }
+    };
+
+    ScanTask(ScanTask&& other) noexcept : handle_(exchange(other.handle_, {})) {}
+    ScanTask& operator=(ScanTask&&) = delete;
+    ~ScanTask() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool done() const { return !handle_ || handle_.done(); }
+
+    /**
+     * @brief Rethrows an exception raised by the scan, if any.
+     */
+    void rethrowIfFailed() const {
+        if (handle_ && handle_.promise().exception) {
+            rethrow_exception(handle_.promise().exception);
+        }
+    }
+
+private:
+    explicit ScanTask(coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    coroutine_handle<promise_type> handle_;
+};
+
+/**
+ * @brief Scans chunks awaited from an asynchronous reader, reporting matches as they are found.
+ *
+ * The coroutine suspends while waiting for input, so thousands of scans can be interleaved on
+ * one thread without a stack per scan.
+ *
+ * @param reader The chunk source, e.g. a ChunkChannel; must outlive the scan.
+ * @param pattern The pattern to search for.
+ * @param on_match Called with the stream offset of each match start.
+ * @return The task handle of the running scan.
+ */
+template <class AsyncReader>
+ScanTask asyncKMPScan(AsyncReader& reader, string pattern, function<void(size_t)> on_match) {
+    KMPStreamMatcher matcher(pattern);
+    while (optional<string> chunk = co_await reader.next()) {
+        matcher.feed(*chunk, on_match);
+    }
+}
+
+/**
+ * @brief Thrown by a cancelled search when its result is requested.
+ */
+class SearchCancelled : public runtime_error {
+public:
+    SearchCancelled() : runtime_error("search cancelled") {}
+};
+
+/**
+ * @brief Shared cancellation flag; copies refer to the same flag.
+ */
+class CancellationToken {
+public:
+    void cancel() { flag_->store(true, memory_order_relaxed); }
+    bool cancelled() const { return flag_->load(memory_order_relaxed); }
+
+private:
+    shared_ptr<atomic<bool>> flag_ = make_shared<atomic<bool>>(false);
+};
+
+/**
+ * @brief Outcome of a scan run under ScanLimits.
+ */
+enum class ScanStatus {
+    Completed,        // the whole text was scanned
+    Cancelled,        // the cancellation token was triggered
+    DeadlineExceeded, // the deadline passed
+};
+
+/**
+ * @brief Limits checked by interruptible scans.
+ *
+ * Limits are checked once every check_interval bytes, between blocks of the scan loop, so the
+ * inner loop is unchanged and the cost (one relaxed load and one clock read per block) is not
+ * measurable at the default interval.
+ */
+struct ScanLimits {
+    const CancellationToken* token = nullptr;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+    size_t check_interval = 64 * 1024;
+};
+
+/**
+ * @brief Returns Completed if a scan may continue, or the reason it has to stop.
+ */
+ScanStatus checkScanLimits(const ScanLimits& limits) {
+    if (limits.token != nullptr && limits.token->cancelled()) {
+        return ScanStatus::Cancelled;
+    }
+    if (limits.deadline != chrono::steady_clock::time_point::max() &&
+        chrono::steady_clock::now() >= limits.deadline) {
+        return ScanStatus::DeadlineExceeded;
+    }
+    return ScanStatus::Completed;
+}
+
+/**
+ * @brief Resume state of an interrupted per-position KMP search.
+ */
+struct KMPScanState {
+    size_t position = 0; // next text position to scan; lps[0, position) is final
+    int j = 0;           // pattern state before text[position]
+};
+
+/**
+ * @brief Runs or resumes a per-position KMP search that stops when a limit is hit.
+ *
+ * Scanning starts at state.position. On return, lps[0, state.position) holds the same values as
+ * KMPSearch(text, pattern) and state can be passed back to continue the scan.
+ *
+ * @param text The main text to search within.
+ * @param pattern The compiled pattern to search for.
+ * @param lps Output buffer; at least text.length() elements.
+ * @param state The resume state, updated in place.
+ * @param limits The cancellation token, deadline and check interval.
+ * @return Completed once the whole text is scanned, otherwise the reason the scan stopped.
+ *
+ * @note Time Complexity: O(n) in total over all resumptions.
+ * @note Space Complexity: O(1) beyond the output buffer.
+ */
+ScanStatus KMPSearch(string_view text, const CompiledPattern& pattern, span<int> lps, KMPScanState& state,
+                     const ScanLimits& limits) {
+    assert(lps.size() >= text.length());
+    if (pattern.length() == 0) {
+        state.position = text.length();
+        return ScanStatus::Completed;
+    }
+    size_t interval = max<size_t>(limits.check_interval, 1);
+    while (state.position < text.length()) {
+        ScanStatus status = checkScanLimits(limits);
+        if (status != ScanStatus::Completed) {
+            return status;
+        }
+        size_t end = min(text.length(), state.position + interval);
+        pattern.visit([&](const auto* records) {
+            state.j = KMPSearchWithRecords(text, records, pattern.length(), lps, state.position, end, state.j);
+        });
+        state.position = end;
+    }
+    return ScanStatus::Completed;
+}
+
+/**
+ * @brief Feeds text[matcher.consumed(), end) to a stream matcher until done or a limit is hit.
+ *
+ * The matcher is the resume state: its consumed() count is the next text position, so calling
+ * again with the same matcher and text continues where the scan stopped.
+ *
+ * @param matcher The stream matcher; its offsets are positions in text.
+ * @param text The main text to search within.
+ * @param matches Receives the offsets of the matches found, appended in increasing order.
+ * @param limits The cancellation token, deadline and check interval.
+ * @return Completed once the whole text is scanned, otherwise the reason the scan stopped.
+ */
+ScanStatus KMPScanWithLimits(KMPStreamMatcher& matcher, string_view text, vector<size_t>& matches,
+                             const ScanLimits& limits) {
+    assert(matcher.consumed() <= text.length());
+    size_t interval = max<size_t>(limits.check_interval, 1);
+    while (matcher.consumed() < text.length()) {
+        ScanStatus status = checkScanLimits(limits);
+        if (status != ScanStatus::Completed) {
+            return status;
+        }
+        matcher.feed(text.substr(matcher.consumed(), interval), [&](size_t offset) { matches.push_back(offset); });
+    }
+    return ScanStatus::Completed;
+}
+
+/**
+ * @brief Scheduling class of a job: interactive jobs always run before bulk ones.
+ */
+enum class JobPriority {
+    Interactive,
+    Bulk,
+};
+
+/**
+ * @brief Priority class and deadline of a scheduled job.
+ *
+ * Within a class, jobs run earliest deadline first and in submission order for equal deadlines.
+ * The deadline only orders jobs; a job past its deadline still runs.
+ */
+struct JobSchedule {
+    JobPriority priority = JobPriority::Interactive;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+};
+
+/**
+ * @brief Fixed-size work-stealing thread pool for search jobs.
+ *
+ * Each worker owns a deque: jobs submitted from a worker go to the back of its own deque and are
+ * popped LIFO, and idle workers steal from the front of other deques. Jobs submitted from other
+ * threads go to a shared injection queue that workers take from in FIFO order once their own
+ * deque is empty, so under sustained load the oldest request is not starved by newer ones. Tiny jobs submitted with submitSmall() are coalesced: they wait in
+ * a shared queue and a worker takes up to batchSize() of them at a time, so a flood of small
+ * searches from many request threads costs one queue operation per batch. The number of
+ * threads, and therefore the CPU used by searches, is bounded by the worker count.
+ *
+ * Jobs submitted with schedule() go to a shared queue ordered by JobSchedule instead: a worker
+ * runs queued interactive jobs before anything else and bulk jobs only when it finds no other
+ * work. Long bulk jobs are expected to split themselves into chunks and reschedule the rest
+ * while interactiveWaiting() is non-zero, as scheduleSearch() does.
+ */
+class SearchThreadPool {
+public:
+    explicit SearchThreadPool(unsigned workers = max(1u, thread::hardware_concurrency()),
+                              size_t small_job_bytes = 16 * 1024, size_t batch_size = 64)
+        : small_job_bytes_(small_job_bytes), batch_size_(batch_size) {
+        for (unsigned k = 0; k < workers; ++k) {
+            queues_.push_back(make_unique<WorkerQueue>());
+        }
+        for (unsigned k = 0; k < workers; ++k) {
+            threads_.emplace_back([this, k] { workerLoop(k); });
+        }
+    }
+
+    /**
+     * @brief Runs all queued jobs, then joins the workers.
+     */
+    ~SearchThreadPool() {
+        {
+            lock_guard<mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (thread& worker : threads_) {
+            worker.join();
+        }
+    }
+
+    SearchThreadPool(const SearchThreadPool&) = delete;
+    SearchThreadPool& operator=(const SearchThreadPool&) = delete;
+
+    void submit(function<void()> job) {
+        WorkerQueue& queue = current_pool_ == this ? *queues_[current_worker_] : injected_;
+        {
+            lock_guard<mutex> lock(queue.lock);
+            queue.jobs.push_back(move(job));
+        }
+        notifyPending(1);
+    }
+
+    void submitSmall(function<void()> job) {
+        {
+            lock_guard<mutex> lock(small_jobs_.lock);
+            small_jobs_.jobs.push_back(move(job));
+        }
+        notifyPending(1);
+    }
+
+    void schedule(function<void()> job, const JobSchedule& schedule) {
+        {
+            lock_guard<mutex> lock(scheduled_lock_);
+            scheduled_.push({schedule.priority, schedule.deadline, scheduled_count_++, move(job)});
+            if (schedule.priority == JobPriority::Interactive) {
+                interactive_waiting_++;
+            }
+        }
+        notifyPending(1);
+    }
+
+    /**
+     * @brief Returns the number of scheduled interactive jobs no worker has taken yet.
+     */
+    size_t interactiveWaiting() const { return interactive_waiting_.load(); }
+
+    unsigned workerCount() const { return threads_.size(); }
+    size_t smallJobBytes() const { return small_job_bytes_; }
+    size_t batchSize() const { return batch_size_; }
+    size_t batchesRun() const { return batches_run_.load(); }
+
+private:
+    struct WorkerQueue {
+        mutex lock;
+        deque<function<void()>> jobs;
+    };
+
+    struct ScheduledJob {
+        JobPriority priority;
+        chrono::steady_clock::time_point deadline;
+        size_t sequence;
+        function<void()> job;
+
+        // Ordered so that the job to run first is the greatest, as priority_queue expects.
+        bool operator<(const ScheduledJob& other) const {
+            return tie(other.priority, other.deadline, other.sequence) < tie(priority, deadline, sequence);
+        }
+    };
+
+    bool runScheduled(JobPriority lowest) {
+        function<void()> job;
+        {
+            lock_guard<mutex> lock(scheduled_lock_);
+            if (scheduled_.empty() || scheduled_.top().priority > lowest) {
+                return false;
+            }
+            job = move(const_cast<ScheduledJob&>(scheduled_.top()).job);
+            if (scheduled_.top().priority == JobPriority::Interactive) {
+                interactive_waiting_--;
+            }
+            scheduled_.pop();
+            pending_--;
+        }
+        job();
+        return true;
+    }
+
+    void notifyPending(size_t count) {
+        {
+            lock_guard<mutex> lock(sleep_mutex_);
+            pending_ += count;
+        }
+        wake_.notify_one();
+    }
+
+    bool runOne(unsigned index) {
+        if (runScheduled(JobPriority::Interactive)) {
+            return true;
+        }
+        function<void()> job;
+        if (popBack(*queues_[index], job) || popFront(injected_, job)) {
+            job();
+            return true;
+        }
+        deque<function<void()>> batch;
+        {
+            lock_guard<mutex> lock(small_jobs_.lock);
+            size_t count = min(batch_size_, small_jobs_.jobs.size());
+            move(small_jobs_.jobs.begin(), small_jobs_.jobs.begin() + count, back_inserter(batch));
+            small_jobs_.jobs.erase(small_jobs_.jobs.begin(), small_jobs_.jobs.begin() + count);
+        }
+        if (!batch.empty()) {
+            pending_ -= batch.size();
+            batches_run_++;
+            for (function<void()>& small_job : batch) {
+                small_job();
+            }
+            return true;
+        }
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            if (popFront(*queues_[(index + k) % queues_.size()], job)) {
+                job();
+                return true;
+            }
+        }
+        return runScheduled(JobPriority::Bulk);
+    }
+
+    bool popBack(WorkerQueue& queue, function<void()>& job) {
+        lock_guard<mutex> lock(queue.lock);
+        if (queue.jobs.empty()) {
+            return false;
+        }
+        job = move(queue.jobs.back());
+        queue.jobs.pop_back();
+        pending_--;
+        return true;
+    }
+
+    bool popFront(WorkerQueue& queue, function<void()>& job) {
+        lock_guard<mutex> lock(queue.lock);
+        if (queue.jobs.empty()) {
+            return false;
+        }
+        job = move(queue.jobs.front());
+        queue.jobs.pop_front();
+        pending_--;
+        return true;
+    }
+
+    void workerLoop(unsigned index) {
+        current_pool_ = this;
+        current_worker_ = index;
+        while (true) {
+            if (runOne(index)) {
+                continue;
+            }
+            unique_lock<mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+            if (stopping_ && pending_ == 0) {
+                return;
+            }
+        }
+    }
+
+    static thread_local SearchThreadPool* current_pool_;
+    static thread_local unsigned current_worker_;
+
+    size_t small_job_bytes_;
+    size_t batch_size_;
+    vector<unique_ptr<WorkerQueue>> queues_;
+    WorkerQueue injected_; // jobs submitted from outside the pool, FIFO
+    WorkerQueue small_jobs_;
+    mutex scheduled_lock_;
+    priority_queue<ScheduledJob> scheduled_;
+    size_t scheduled_count_ = 0;
+    atomic<size_t> interactive_waiting_{0};
+    vector<thread> threads_;
+    mutex sleep_mutex_;
+    condition_variable wake_;
+    atomic<size_t> pending_{0}; // queued jobs not yet taken by a worker
+    atomic<size_t> batches_run_{0};
+    bool stopping_ = false;
+};
+
+thread_local SearchThreadPool* SearchThreadPool::current_pool_ = nullptr;
+thread_local unsigned SearchThreadPool::current_worker_ = 0;
+
+/**
+ * @brief Returns the library-owned pool shared by all asynchronous searches.
+ */
+SearchThreadPool& sharedSearchPool() {
+    static SearchThreadPool pool;
+    return pool;
+}
+
+/**
+ * @brief A search running on a pool: its future result and a token to cancel it.
+ */
+struct AsyncSearch {
+    future<vector<size_t>> result;
+    CancellationToken token;
+
+    void cancel() { token.cancel(); }
+};
+
+/**
+ * @brief Runs a KMP search on a thread pool.
+ *
+ * Texts shorter than pool.smallJobBytes() are submitted as small jobs and batched with other
+ * small searches. A cancelled search stops before it starts or at its next limit check, and its
+ * future throws SearchCancelled.
+ *
+ * @param text The main text to search within; it must stay alive until the result is ready.
+ * @param pattern The pattern to search for (copied).
+ * @param pool The pool to run on; defaults to the shared library pool.
+ * @return The future offsets of all matches, and the cancellation token of the search.
+ */
+AsyncSearch asyncSearch(string_view text, string_view pattern, SearchThreadPool& pool = sharedSearchPool()) {
+    auto promise = make_shared<std::promise<vector<size_t>>>();
+    AsyncSearch search{promise->get_future(), CancellationToken()};
+    function<void()> job = [text, pattern = string(pattern), promise, token = search.token] {
+        if (token.cancelled()) {
+            promise->set_exception(make_exception_ptr(SearchCancelled()));
+            return;
+        }
+        try {
+            KMPStreamMatcher matcher(pattern);
+            vector<size_t> matches;
+            ScanLimits limits;
+            limits.token = &token;
+            if (KMPScanWithLimits(matcher, text, matches, limits) == ScanStatus::Cancelled) {
+                promise->set_exception(make_exception_ptr(SearchCancelled()));
+                return;
+            }
+            promise->set_value(move(matches));
+        } catch (...) {
+            promise->set_exception(current_exception());
+        }
+    };
+    if (text.length() < pool.smallJobBytes()) {
+        pool.submitSmall(move(job));
+    } else {
+        pool.submit(move(job));
+    }
+    return search;
+}
+
+/**
+ * @brief Runs a KMP search on a thread pool with a priority class and deadline.
+ *
+ * Interactive searches scan the whole text in one job. Bulk searches scan chunk_bytes at a
+ * time and, whenever an interactive job is waiting after a chunk, reschedule the rest of the
+ * scan with the same schedule; the stream matcher state carries over, so preemption costs one
+ * queue round trip per chunk and interactive queries wait for at most one chunk per worker.
+ *
+ * @param text The main text to search within; it must stay alive until the result is ready.
+ * @param pattern The pattern to search for (copied).
+ * @param schedule The priority class and deadline of the search.
+ * @param pool The pool to run on; defaults to the shared library pool.
+ * @param chunk_bytes The bytes a bulk search scans between preemption points.
+ * @return The future offsets of all matches, and the cancellation token of the search.
+ */
+AsyncSearch scheduleSearch(string_view text, string_view pattern, const JobSchedule& schedule,
+                           SearchThreadPool& pool = sharedSearchPool(), size_t chunk_bytes = 256 * 1024) {
+    struct State {
+        KMPStreamMatcher matcher;
+        vector<size_t> matches;
+        std::promise<vector<size_t>> promise;
+    };
+    struct ScanJob {
+        string_view text;
+        shared_ptr<State> state;
+        JobSchedule schedule;
+        SearchThreadPool* pool;
+        CancellationToken token;
+        size_t chunk_bytes;
+
+        void operator()() const {
+            try {
+                ScanLimits limits;
+                limits.token = &token;
+                while (true) {
+                    size_t end = schedule.priority == JobPriority::Bulk
+                                     ? min(text.length(), state->matcher.consumed() + chunk_bytes)
+                                     : text.length();
+                    if (token.cancelled() ||
+                        KMPScanWithLimits(state->matcher, text.substr(0, end), state->matches, limits) ==
+                            ScanStatus::Cancelled) {
+                        state->promise.set_exception(make_exception_ptr(SearchCancelled()));
+                        return;
+                    }
+                    if (end == text.length()) {
+                        state->promise.set_value(move(state->matches));
+                        return;
+                    }
+                    if (pool->interactiveWaiting() > 0) {
+                        pool->schedule(*this, schedule);
+                        return;
+                    }
+                }
+            } catch (...) {
+                state->promise.set_exception(current_exception());
+            }
+        }
+    };
+    auto state = make_shared<State>(State{KMPStreamMatcher(pattern), {}, {}});
+    AsyncSearch search{state->promise.get_future(), CancellationToken()};
+    pool.schedule(ScanJob{text, state, schedule, &pool, search.token, max<size_t>(chunk_bytes, 1)}, schedule);
+    return search;
+}
+
+/**
+ * @brief Search engines covered by SearchCostModel.
+ */
+enum class SearchEngine {
+    Standard,   // KMPSearch with int LPS tables
+    Compiled,   // KMPSearch with a CompiledPattern
+    Compressed, // KMPSearchHuge with a CompressedLPS
+    Streaming,  // KMPStreamMatcher, as used by the async, scheduled and parallel searches
+};
+
+/**
+ * @brief Returns the smallest period of a pattern, m - lps[m - 1], or 0 for an empty pattern.
+ */
+size_t patternPeriod(string_view pattern) {
+    if (pattern.empty()) {
+        return 0;
+    }
+    return pattern.length() - computeLPS(pattern).back();
+}
+
+/**
+ * @brief Predicts the CPU time of a search before it runs, for admission control.
+ *
+ * The cost of an engine is a preprocessing term linear in the pattern length plus a scanning
+ * term linear in the text length. The scanning cost per byte is interpolated between its value
+ * on random binary text and its value on the slowest of three fallback-heavy fixtures by the
+ * periodicity 1 - period / m of the pattern, since only periodic patterns have long fallback
+ * chains. The fixtures are a^31 b over a^n (one fallback per byte) and a^32 over random binary
+ * text and over text with a b at about one byte in ten (a fallback chain of random length at
+ * every b). The worst case is not clamped to the random one, so the period moves the estimate
+ * only as far as it moves the measured scans. Calibrate at about the size of the searches to
+ * be estimated: output buffers that fit in cache make smaller scans faster per byte.
+ * Scans are timed into a preallocated buffer; engines whose entry points return an lps vector
+ * add the cost of allocating, zeroing and freeing it, about a fifth of a scan at 16 MiB.
+ * The estimate is CPU time: a parallel search spends about the same in total, spread over its
+ * workers.
+ */
+class SearchCostModel {
+public:
+    struct EngineCost {
+        double setup_ns_per_pattern_byte = 0;
+        double typical_ns_per_text_byte = 0; // random binary text and pattern
+        double worst_ns_per_text_byte = 0;   // pattern of period 1, fallback-heavy text
+        double output_ns_per_text_byte = 0;  // the lps vector returned by the entry point
+    };
+
+    SearchCostModel() = default;
+    explicit SearchCostModel(const array<EngineCost, 4>& costs) : costs_(costs) {}
+
+    /**
+     * @brief Fits every engine's costs with the benchmarks' timing loop.
+     *
+     * @param sample_bytes The text length of the timed scans; patterns for the setup term are
+     *                     a quarter of it.
+     */
+    static SearchCostModel calibrate(size_t sample_bytes = 4 << 20) {
+        sample_bytes = max<size_t>(sample_bytes, 4096);
+        string long_pattern = randomText(sample_bytes / 4, 4, 19);
+        string random_text = randomText(sample_bytes, 2, 23);
+        string random_pattern = randomText(32, 2, 29);
+        string step_pattern = string(31, 'a') + 'b';
+        string step_text(sample_bytes, 'a');
+        string chain_pattern(32, 'a');
+        string chain_text(sample_bytes, 'a');
+        mt19937_64 generator(41);
+        for (char& c : chain_text) {
+            c = generator() % 10 == 0 ? 'b' : 'a';
+        }
+        auto perByte = [](double milliseconds, size_t bytes) { return milliseconds * 1e6 / bytes; };
+        size_t checksum = 0;
+        array<EngineCost, 4> costs;
+        vector<int> lps(sample_bytes);
+        vector<int> released;
+        double output_ns_per_text_byte = perByte(measureMilliseconds([&] {
+            vector<int> returned(sample_bytes);
+            released.swap(returned);
+        }), sample_bytes);
+
+        // Each engine is timed as build(pattern) for setup and scan(text, built, pattern) for
+        // scanning; scans write into lps, so allocating it is fitted separately above.
+        auto fit = [&](SearchEngine engine, auto build, auto scan) {
+            EngineCost& cost = costs[size_t(engine)];
+            cost.setup_ns_per_pattern_byte =
+                perByte(measureMilliseconds([&] { build(long_pattern); }), long_pattern.length());
+            auto typical = build(random_pattern);
+            cost.typical_ns_per_text_byte =
+                perByte(measureMilliseconds([&] { scan(random_text, typical, random_pattern); }), random_text.length());
+            auto step = build(step_pattern);
+            auto chain = build(chain_pattern);
+            cost.worst_ns_per_text_byte = max({
+                perByte(measureMilliseconds([&] { scan(step_text, step, step_pattern); }), step_text.length()),
+                perByte(measureMilliseconds([&] { scan(random_text, chain, chain_pattern); }), random_text.length()),
+                perByte(measureMilliseconds([&] { scan(chain_text, chain, chain_pattern); }), chain_text.length()),
+            });
+        };
+        fit(SearchEngine::Standard, [](const string& pattern) { return computeLPS(pattern); },
+            [&](const string& text, const vector<int>& lps_pattern, const string& pattern) {
+                KMPSearchWithTable(text, pattern.data(), lps_pattern.data(), pattern.length(), lps);
+                checksum += lps[text.length() - 1];
+            });
+        fit(SearchEngine::Compiled, [](const string& pattern) { return make_shared<CompiledPattern>(pattern); },
+            [&](const string& text, const shared_ptr<CompiledPattern>& compiled, const string&) {
+                KMPSearch(text, *compiled, lps);
+                checksum += lps[text.length() - 1];
+            });
+        fit(SearchEngine::Compressed, [](const string& pattern) { return make_shared<CompressedLPS>(pattern); },
+            [&](const string& text, const shared_ptr<CompressedLPS>& compressed, const string& pattern) {
+                checksum += KMPSearchHuge(text, pattern, *compressed).size();
+            });
+        fit(SearchEngine::Streaming, [](const string& pattern) { return KMPStreamMatcher(pattern); },
+            [&](const string& text, KMPStreamMatcher matcher, const string&) {
+                matcher.feed(text, [&](size_t) { checksum++; });
+            });
+        costs[size_t(SearchEngine::Standard)].output_ns_per_text_byte = output_ns_per_text_byte;
+        costs[size_t(SearchEngine::Compiled)].output_ns_per_text_byte = output_ns_per_text_byte;
+        // Publishing the checksum keeps the timed scans from being optimized away.
+        calibration_results_.fetch_add(checksum, memory_order_relaxed);
+        return SearchCostModel(costs);
+    }
+
+    /**
+     * @param text_length The length of the text to search.
+     * @param pattern_length The length of the pattern.
+     * @param period The smallest period of the pattern, see patternPeriod().
+     * @param engine The engine the search will run on.
+     * @return The estimated CPU time of the search, preprocessing included, in milliseconds.
+     */
+    double estimateMilliseconds(size_t text_length, size_t pattern_length, size_t period, SearchEngine engine) const {
+        const EngineCost& cost = costs_[size_t(engine)];
+        if (pattern_length == 0) {
+            return 0;
+        }
+        double periodicity = 1.0 - double(min(max<size_t>(period, 1), pattern_length)) / pattern_length;
+        double scan_ns_per_byte = cost.typical_ns_per_text_byte +
+                                  (cost.worst_ns_per_text_byte - cost.typical_ns_per_text_byte) * periodicity +
+                                  cost.output_ns_per_text_byte;
+        return (pattern_length * cost.setup_ns_per_pattern_byte + text_length * scan_ns_per_byte) / 1e6;
+    }
+
+    double estimateMilliseconds(size_t text_length, string_view pattern, SearchEngine engine) const {
+        return estimateMilliseconds(text_length, pattern.length(), patternPeriod(pattern), engine);
+    }
+
+    const EngineCost& cost(SearchEngine engine) const { return costs_[size_t(engine)]; }
+
+private:
+    static inline atomic<size_t> calibration_results_{0};
+
+    array<EngineCost, 4> costs_;
+};
+
+#ifdef __linux__
+/**
+ * @brief Anonymous shared memory mapping, inherited by forked worker processes.
+ *
+ * Pages are reserved lazily (MAP_NORESERVE), so a region sized for the worst case only costs
+ * the pages actually written.
+ */
+class SharedMemoryRegion {
+public:
+    explicit SharedMemoryRegion(size_t bytes) : bytes_(max<size_t>(bytes, 1)) {
+        address_ = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (address_ == MAP_FAILED) {
+            throw system_error(errno, generic_category(), "mmap");
+        }
+    }
+
+    ~SharedMemoryRegion() {
+        if (address_ != nullptr) {
+            munmap(address_, bytes_);
+        }
+    }
+
+    SharedMemoryRegion(SharedMemoryRegion&& other) noexcept
+        : address_(exchange(other.address_, nullptr)), bytes_(other.bytes_) {}
+    SharedMemoryRegion& operator=(SharedMemoryRegion&&) = delete;
+
+    void* data() const { return address_; }
+    size_t size() const { return bytes_; }
+
+    void makeReadOnly() {
+        if (mprotect(address_, bytes_, PROT_READ) != 0) {
+            throw system_error(errno, generic_category(), "mprotect");
+        }
+    }
+
+private:
+    void* address_;
+    size_t bytes_;
+};
+
+/**
+ * @brief Searches a text with a pool of forked worker processes over shared memory.
+ *
+ * The text is copied once into a shared read-only mapping and the pattern is preprocessed before
+ * forking, so all workers read the same physical pages. Worker w scans its shard
+ * [start, end) extended by m - 1 bytes, starting from the empty pattern state at start, which
+ * finds exactly the matches starting inside the shard. Each worker writes its offsets into its
+ * own shared result region; since shards are disjoint and ordered, the coordinator merges the
+ * per-worker lists by concatenating them in shard order. A worker that crashes or is killed
+ * makes the whole search fail instead of returning a silently incomplete result.
+ *
+ * @param text The main text to search within.
+ * @param pattern The pattern to search for.
+ * @param workers The number of worker processes.
+ * @return The offsets of all matches in increasing order.
+ * @throws system_error if a mapping or fork fails, runtime_error if a worker does not exit cleanly.
+ */
+vector<size_t> multiProcessSearch(string_view text, string_view pattern, unsigned workers) {
+    size_t n = text.length();
+    size_t m = pattern.length();
+    if (m == 0 || n < m) {
+        return {};
+    }
+    workers = max<size_t>(1, min<size_t>(workers, n));
+
+    SharedMemoryRegion shared_text(n);
+    memcpy(shared_text.data(), text.data(), n);
+    shared_text.makeReadOnly();
+    string_view view(static_cast<const char*>(shared_text.data()), n);
+    KMPStreamMatcher matcher(pattern);
+
+    size_t shard = (n + workers - 1) / workers;
+    vector<SharedMemoryRegion> results;
+    vector<pid_t> children;
+    for (unsigned w = 0; w < workers && w * shard < n; ++w) {
+        size_t start = w * shard;
+        size_t end = min(n, start + shard);
+        // Slot 0 holds the match count, followed by the offsets.
+        results.emplace_back((end - start + 1) * sizeof(size_t));
+        size_t* slots = static_cast<size_t*>(results.back().data());
+        pid_t child = fork();
+        if (child < 0) {
+            int error = errno;
+            for (pid_t started : children) {
+                waitpid(started, nullptr, 0);
+            }
+            throw system_error(error, generic_category(), "fork");
+        }
+        if (child == 0) {
+            size_t count = 0;
+            matcher.feed(view.substr(start, end - start + m - 1),
+                         [&](size_t offset) { slots[1 + count++] = start + offset; });
+            slots[0] = count;
+            _exit(0);
+        }
+        children.push_back(child);
+    }
+
+    bool failed = false;
+    for (pid_t child : children) {
+        int status = 0;
+        if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            failed = true;
+        }
+    }
+    if (failed) {
+        throw runtime_error("multiProcessSearch: a worker process failed");
+    }
+
+    vector<size_t> matches;
+    for (const SharedMemoryRegion& result : results) {
+        const size_t* slots = static_cast<const size_t*>(result.data());
+        matches.insert(matches.end(), slots + 1, slots + 1 + slots[0]);
+    }
+    return matches;
+}
+#endif
+
+/**
+ * @brief A match of one pattern out of a set, ordered by offset and then by pattern id.
+ */
+struct PatternMatch {
+    size_t offset;
+    int pattern_id;
+
+    auto operator<=>(const PatternMatch&) const = default;
+};
+
+/**
+ * @brief Merges sorted per-shard match streams into one globally ordered, deduplicated stream.
+ *
+ * Producers push the matches of each shard in increasing order; each shard buffers at most
+ * buffer_capacity matches and push() blocks while it is full. run() emits a match once no
+ * unfinished shard could still produce a smaller one: a shard can only produce matches at or
+ * after its floor, which starts at the lower bound given for the shard and rises with every
+ * match pushed. Equal consecutive matches, e.g. found twice in overlapping shard borders, are
+ * emitted once, so the output is identical to a sequential scan.
+ */
+class OrderedMatchMerger {
+public:
+    /**
+     * @param lower_bounds For each shard, an offset no match of that shard is below.
+     * @param buffer_capacity The maximum number of buffered matches per shard.
+     * @param sink Called on the run() thread with each match, in order.
+     */
+    OrderedMatchMerger(vector<size_t> lower_bounds, size_t buffer_capacity, function<void(const PatternMatch&)> sink)
+        : shards_(lower_bounds.size()), buffer_capacity_(max<size_t>(buffer_capacity, 1)), sink_(move(sink)) {
+        for (size_t k = 0; k < shards_.size(); ++k) {
+            shards_[k].floor = lower_bounds[k];
+            waiting_.insert({shards_[k].floor, k});
+        }
+    }
+
+    void push(size_t shard, const PatternMatch& match) {
+        unique_lock<mutex> lock(mutex_);
+        Shard& state = shards_[shard];
+        assert(!state.finished && match.offset >= state.floor);
+        space_.wait(lock, [&] { return state.buffer.size() < buffer_capacity_; });
+        if (state.buffer.empty()) {
+            waiting_.erase({state.floor, shard});
+            heads_.insert({match, shard});
+            ready_.notify_one();
+        }
+        state.buffer.push_back(match);
+        state.floor = match.offset;
+    }
+
+    void finish(size_t shard) {
+        lock_guard<mutex> lock(mutex_);
+        Shard& state = shards_[shard];
+        state.finished = true;
+        if (state.buffer.empty()) {
+            waiting_.erase({state.floor, shard});
+            ready_.notify_one();
+        }
+    }
+
+    /**
+     * @brief Emits matches to the sink until every shard is finished and drained.
+     */
+    void run() {
+        unique_lock<mutex> lock(mutex_);
+        optional<PatternMatch> last;
+        while (!heads_.empty() || !waiting_.empty()) {
+            // A waiting shard is unfinished and empty, so it may still produce a match at its floor.
+            if (heads_.empty() || (!waiting_.empty() && waiting_.begin()->first <= heads_.begin()->first.offset)) {
+                ready_.wait(lock);
+                continue;
+            }
+            auto [match, shard] = *heads_.begin();
+            heads_.erase(heads_.begin());
+            Shard& state = shards_[shard];
+            state.buffer.pop_front();
+            if (!state.buffer.empty()) {
+                heads_.insert({state.buffer.front(), shard});
+            } else if (!state.finished) {
+                waiting_.insert({state.floor, shard});
+            }
+            if (state.buffer.size() + 1 == buffer_capacity_) {
+                space_.notify_all();
+            }
+            if (last != match) {
+                last = match;
+                lock.unlock();
+                sink_(match);
+                lock.lock();
+            }
+        }
+    }
+
+private:
+    struct Shard {
+        deque<PatternMatch> buffer;
+        size_t floor = 0; // no future match of this shard is below floor
+        bool finished = false;
+    };
+
+    vector<Shard> shards_;
+    set<pair<PatternMatch, size_t>> heads_; // front match of every non-empty shard
+    set<pair<size_t, size_t>> waiting_;     // (floor, shard) of every unfinished empty shard
+    size_t buffer_capacity_;
+    function<void(const PatternMatch&)> sink_;
+    mutex mutex_;
+    condition_variable ready_; // signalled to run() when a waiting shard gets a match or finishes
+    condition_variable space_; // signalled to producers when a full buffer gets room
+};
+
+/**
+ * @brief Settings of the parallel chunked scan.
+ */
+struct ParallelScanConfig {
+    unsigned workers = max(1u, thread::hardware_concurrency());
+    size_t chunk_size = 1 << 20;    // text bytes per chunk
+    size_t buffer_capacity = 4096;  // buffered matches per chunk in the merger
+    bool pin_threads = false;       // pin worker w to the w-th allowed CPU, round robin, where allowed
+};
+
+/**
+ * @brief Pins the calling thread to the index-th CPU of its affinity mask, wrapping around.
+ *
+ * @return 0 if the thread was pinned, otherwise the error: ENOSYS where affinity is not
+ *         supported, EPERM or EINVAL where the environment (e.g. a container) forbids it.
+ */
+int pinThreadToCpu(unsigned index) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return errno;
+    }
+    if (CPU_COUNT(&allowed) == 0) {
+        return EINVAL;
+    }
+    unsigned target = index % CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0) {
+            cpu_set_t single;
+            CPU_ZERO(&single);
+            CPU_SET(cpu, &single);
+            return pthread_setaffinity_np(pthread_self(), sizeof(single), &single);
+        }
+    }
+    return EINVAL;
+#else
+    (void)index;
+    return ENOSYS;
+#endif
+}
+
+/**
+ * @brief Scans a text for a set of patterns with worker threads and streams the ordered matches.
+ *
+ * The text is split into chunks handed out to workers in increasing order. A chunk
+ * [start, end) is scanned from the empty pattern state at start, up to end + m - 1 for each
+ * pattern, so it reports exactly the matches starting inside it. Each chunk is a shard of an
+ * OrderedMatchMerger with its start as lower bound, and the calling thread drains the merger
+ * into the sink, so the sink sees the same sequence as a sequential scan whatever the number
+ * of workers.
+ *
+ * @param text The main text to search within.
+ * @param patterns The patterns to search for; a match's pattern_id is its index here.
+ * @param sink Called on the calling thread with every match, ordered by offset then pattern id.
+ * @param config Worker count, chunk size and merger buffer capacity.
+ * @return The number of workers that could not be pinned to a CPU; 0 unless config.pin_threads.
+ *         Unpinned workers still scan their chunks.
+ */
+unsigned parallelKMPSearch(string_view text, const vector<string>& patterns, function<void(const PatternMatch&)> sink,
+                           const ParallelScanConfig& config = ParallelScanConfig()) {
+    size_t chunk_size = max<size_t>(config.chunk_size, 1);
+    size_t chunks = (text.length() + chunk_size - 1) / chunk_size;
+    vector<size_t> lower_bounds(chunks);
+    for (size_t c = 0; c < chunks; ++c) {
+        lower_bounds[c] = c * chunk_size;
+    }
+    OrderedMatchMerger merger(lower_bounds, config.buffer_capacity, move(sink));
+    vector<KMPStreamMatcher> prototypes(patterns.begin(), patterns.end());
+    atomic<size_t> next_chunk{0};
+    atomic<unsigned> pin_failures{0};
+
+    auto worker = [&](unsigned index) {
+        if (config.pin_threads && pinThreadToCpu(index) != 0) {
+            pin_failures.fetch_add(1, memory_order_relaxed);
+        }
+        vector<KMPStreamMatcher> matchers = prototypes;
+        vector<PatternMatch> found;
+        for (size_t c = next_chunk++; c < chunks; c = next_chunk++) {
+            size_t start = c * chunk_size;
+            size_t end = min(text.length(), start + chunk_size);
+            found.clear();
+            for (size_t p = 0; p < matchers.size(); ++p) {
+                if (patterns[p].empty()) {
+                    continue;
+                }
+                matchers[p].restore(0, 0);
+                matchers[p].feed(text.substr(start, end - start + patterns[p].length() - 1),
+                                 [&](size_t offset) { found.push_back({start + offset, (int)p}); });
+            }
+            sort(found.begin(), found.end());
+            for (const PatternMatch& match : found) {
+                merger.push(c, match);
+            }
+            merger.finish(c);
+        }
+    };
+
+    vector<thread> threads;
+    for (unsigned w = 0; w < max(1u, config.workers); ++w) {
+        threads.emplace_back(worker, w);
+    }
+    merger.run();
+    for (thread& t : threads) {
+        t.join();
+    }
+    return pin_failures.load(memory_order_relaxed);
+}
+
+/**
+ * @brief Picks the chunk size and worker count of parallelKMPSearch from short timed runs.
+ *
+ * Chunk sizes from 16 KiB to 4 MiB are timed with max_workers workers, never below 16 times
+ * the longest pattern since each chunk rescans m - 1 bytes past its end. The worker count is
+ * then chosen from powers of two at the best chunk size, preferring the fewest workers within
+ * 5% of the fastest run, so slow or shared cores are left out when they do not help. Meant to
+ * run once at startup on a few MiB of representative text.
+ *
+ * @param sample The text the runs are timed on.
+ * @param patterns The patterns the runs search for.
+ * @param max_workers The largest worker count to try.
+ * @param pin_threads Whether the runs, and the returned configuration, pin workers to CPUs.
+ *                    Pinning is left off in the result if any worker could not be pinned.
+ * @return The fastest configuration found.
+ */
+ParallelScanConfig calibrateParallelScan(string_view sample, const vector<string>& patterns,
+                                         unsigned max_workers = max(1u, thread::hardware_concurrency()),
+                                         bool pin_threads = false) {
+    size_t longest = 0;
+    for (const string& pattern : patterns) {
+        longest = max(longest, pattern.length());
+    }
+    ParallelScanConfig config;
+    config.workers = max(1u, max_workers);
+    config.pin_threads = pin_threads;
+    size_t count = 0;
+    unsigned pin_failures = 0;
+    auto time = [&] {
+        return measureMilliseconds([&] {
+            pin_failures += parallelKMPSearch(sample, patterns, [&](const PatternMatch&) { count++; }, config);
+        }, 2);
+    };
+
+    size_t min_chunk = max<size_t>(4096, 16 * longest);
+    size_t best_chunk = max(min_chunk, sample.length());
+    double best_ms = numeric_limits<double>::max();
+    for (size_t chunk = size_t(16) << 10; chunk <= size_t(4) << 20; chunk *= 4) {
+        if (chunk > min_chunk && chunk >= sample.length() * 2) {
+            break; // larger chunks only leave workers idle on this sample
+        }
+        config.chunk_size = max(chunk, min_chunk);
+        double ms = time();
+        if (ms < best_ms) {
+            best_ms = ms;
+            best_chunk = config.chunk_size;
+        }
+    }
+    config.chunk_size = best_chunk;
+
+    unsigned max_count = config.workers;
+    vector<pair<unsigned, double>> runs;
+    for (unsigned workers = 1;; workers = min(workers * 2, max_count)) {
+        config.workers = workers;
+        runs.push_back({workers, time()});
+        if (workers == max_count) {
+            break;
+        }
+    }
+    double fastest = numeric_limits<double>::max();
+    for (const auto& [workers, ms] : runs) {
+        fastest = min(fastest, ms);
+    }
+    for (const auto& [workers, ms] : runs) {
+        if (ms <= fastest * 1.05) {
+            config.workers = workers;
+            break;
+        }
+    }
+    config.pin_threads = pin_threads && pin_failures == 0;
+    return config;
+}
+
+/**
+ * @brief Estimated number of matches in a text, with a 95% confidence interval.
+ */
+struct ApproximateCount {
+    double estimate = 0;
+    double lower = 0;
+    double upper = 0;
+    size_t sampled_blocks = 0;
+    size_t total_blocks = 0;
+
+    bool exact() const { return sampled_blocks == total_blocks; }
+};
+
+/**
+ * @brief Estimates the number of matches by scanning a random sample of blocks.
+ *
+ * Match start offsets are split into blocks of block_size bytes. A block is scanned from the
+ * empty pattern state at its start, through m - 1 bytes past its end, so the matches starting
+ * in it are counted exactly, as in a full scan. sample_blocks blocks are drawn without
+ * replacement, and the total is extrapolated as total_blocks times the mean block count, with a
+ * normal 95% interval whose variance includes the finite population correction; sampling every
+ * block gives the exact count with an empty interval. The cost is proportional to the sampled
+ * bytes only.
+ *
+ * @param text The main text to search within.
+ * @param pattern The pattern to count.
+ * @param sample_blocks The number of blocks to scan; at least one when the text is not empty.
+ * @param block_size The bytes of match start offsets per block.
+ * @param seed The seed of the block sample.
+ */
+ApproximateCount KMPCountApproximate(string_view text, string_view pattern, size_t sample_blocks,
+                                     size_t block_size = 1 << 20, uint64_t seed = 1) {
+    ApproximateCount count;
+    block_size = max<size_t>(block_size, 1);
+    size_t n = text.length(), m = pattern.length();
+    if (m == 0 || m > n) {
+        return count;
+    }
+    size_t total = (n - m) / block_size + 1; // blocks holding the possible start offsets
+    size_t sampled = clamp<size_t>(sample_blocks, 1, total);
+
+    // Floyd's sampling: memory in the sample size, not in the number of blocks.
+    unordered_set<size_t> chosen;
+    chosen.reserve(sampled);
+    mt19937_64 generator(seed);
+    for (size_t j = total - sampled; j < total; ++j) {
+        size_t block = generator() % (j + 1);
+        chosen.insert(chosen.contains(block) ? j : block);
+    }
+    vector<size_t> blocks(chosen.begin(), chosen.end());
+    sort(blocks.begin(), blocks.end());
+
+    KMPStreamMatcher matcher(pattern);
+    double sum = 0, sum_squares = 0;
+    for (size_t block : blocks) {
+        size_t start = block * block_size;
+        size_t matches = 0;
+        matcher.restore(0, 0);
+        matcher.feed(text.substr(start, block_size + m - 1), [&](size_t) { matches++; });
+        sum += matches;
+        sum_squares += double(matches) * matches;
+    }
+
+    double mean = sum / sampled;
+    double variance = sampled > 1 ? max(0.0, (sum_squares - sampled * mean * mean) / (sampled - 1)) : 0;
+    double correction = 1.0 - double(sampled) / total;
+    double half_width = 1.96 * total * sqrt(correction * variance / sampled);
+    count.estimate = mean * total;
+    count.lower = max(0.0, count.estimate - half_width);
+    count.upper = count.estimate + half_width;
+    count.sampled_blocks = sampled;
+    count.total_blocks = total;
+    return count;
+}
+
+/**
+ * @brief Per-pattern event counts over a sliding window, kept in a ring of buckets.
+ *
+ * Positions are in window units (bytes or milliseconds). The window is split into buckets
+ * of ceil(window / buckets) units, and the counts cover the buckets from the one holding the
+ * newest position back to buckets - 1 before it, so the window is exact to one bucket width.
+ * Running totals are updated on every add and expiry, so count() is O(1); advancing by d
+ * buckets costs O(min(d, buckets) * patterns), and memory is O(buckets * patterns).
+ */
+class SlidingWindowCounter {
+public:
+    SlidingWindowCounter(size_t patterns, uint64_t window, size_t buckets)
+        : patterns_(patterns), buckets_(max<size_t>(buckets, 1)),
+          width_(max<uint64_t>((window + buckets_ - 1) / buckets_, 1)), ring_(buckets_ * patterns), totals_(patterns) {}
+
+    /**
+     * @brief Counts an event of a pattern at a position; events older than the window are ignored.
+     */
+    void add(size_t pattern, uint64_t position) {
+        uint64_t bucket = position / width_;
+        advanceToBucket(bucket);
+        if (bucket + buckets_ <= head_) {
+            return;
+        }
+        ring_[(bucket % buckets_) * patterns_ + pattern]++;
+        totals_[pattern]++;
+    }
+
+    /**
+     * @brief Moves the window forward to end at a position, expiring older buckets.
+     */
+    void advance(uint64_t position) { advanceToBucket(position / width_); }
+
+    uint64_t count(size_t pattern) const { return totals_[pattern]; }
+    const vector<uint64_t>& counts() const { return totals_; }
+    uint64_t bucketWidth() const { return width_; }
+    size_t bucketCount() const { return buckets_; }
+
+private:
+    void advanceToBucket(uint64_t bucket) {
+        if (bucket <= head_) {
+            return;
+        }
+        uint64_t expired = min<uint64_t>(bucket - head_, buckets_);
+        for (uint64_t k = 1; k <= expired; ++k) {
+            uint64_t* row = &ring_[((head_ + k) % buckets_) * patterns_];
+            for (size_t p = 0; p < patterns_; ++p) {
+                totals_[p] -= row[p];
+                row[p] = 0;
+            }
+        }
+        head_ = bucket;
+    }
+
+    size_t patterns_;
+    size_t buckets_;
+    uint64_t width_;
+    uint64_t head_ = 0;       // bucket of the newest position
+    vector<uint64_t> ring_;   // buckets_ rows of per-pattern counts
+    vector<uint64_t> totals_; // per-pattern sums over the ring
+};
+
+/**
+ * @brief Unit of a sliding match window.
+ */
+enum class WindowUnit {
+    Bytes,        // positions are stream offsets of the last byte of matches
+    Milliseconds, // positions are feed times
+};
+
+/**
+ * @brief Streams chunks through one KMPStreamMatcher per pattern and keeps windowed match counts.
+ *
+ * Instead of emitting every match, the counter keeps per-pattern counts over the last window
+ * bytes of the stream or the last window milliseconds, which alerting can poll with count()
+ * at any rate independent of the match volume.
+ */
+class WindowedMatchCounter {
+public:
+    WindowedMatchCounter(const vector<string>& patterns, WindowUnit unit, uint64_t window, size_t buckets = 60)
+        : matchers_(patterns.begin(), patterns.end()), unit_(unit), counter_(patterns.size(), window, buckets) {}
+
+    /**
+     * @brief Scans a chunk; in Milliseconds mode its matches are counted at time now.
+     */
+    void feed(string_view chunk, chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        uint64_t time = toMilliseconds(now);
+        if (unit_ == WindowUnit::Milliseconds) {
+            counter_.advance(time);
+        } else if (!chunk.empty()) {
+            counter_.advance(consumed_ + chunk.length() - 1);
+        }
+        for (size_t p = 0; p < matchers_.size(); ++p) {
+            size_t last = matchers_[p].patternLength() - 1;
+            matchers_[p].feed(chunk, [&](size_t offset) { counter_.add(p, unit_ == WindowUnit::Bytes ? offset + last : time); });
+        }
+        consumed_ += chunk.length();
+    }
+
+    /**
+     * @brief Expires time-window buckets without new data, e.g. before polling an idle stream.
+     */
+    void advance(chrono::steady_clock::time_point now = chrono::steady_clock::now()) {
+        if (unit_ == WindowUnit::Milliseconds) {
+            counter_.advance(toMilliseconds(now));
         }
     }
-    return lps;
-}
+
+    uint64_t count(size_t pattern) const { return counter_.count(pattern); }
+    const vector<uint64_t>& counts() const { return counter_.counts(); }
+    size_t consumed() const { return consumed_; }
+
+private:
+    static uint64_t toMilliseconds(chrono::steady_clock::time_point time) {
+        return chrono::duration_cast<chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+
+    vector<KMPStreamMatcher> matchers_;
+    WindowUnit unit_;
+    SlidingWindowCounter counter_;
+    size_t consumed_ = 0;
+};
 
 void testComputeLPS() {
     cout << "Testing computeLPS..." << endl;
@@ -213,6 +3066,1081 @@ void testKMPSearch() {
     cout << "KMPSearch tests finished." << endl << endl;
 }
 
+void testKMPSearchLast() {
+    cout << "Testing KMPSearchLast..." << endl;
+
+    // Test case 1: Empty pattern
+    assert(KMPSearchLast("ABCABC", "") == string::npos);
+    cout << "  Test Case 1 (Empty Pattern): Passed" << endl;
+
+    // Test case 2: Pattern not found
+    assert(KMPSearchLast("ABCDEFG", "XYZ") == string::npos);
+    cout << "  Test Case 2 (Pattern Not Found): Passed" << endl;
+
+    // Test case 3: Text is shorter than pattern
+    assert(KMPSearchLast("ABC", "ABCDE") == string::npos);
+    cout << "  Test Case 3 (Text Shorter than Pattern): Passed" << endl;
+
+    // Test case 4: Single match at beginning
+    assert(KMPSearchLast("ABCDEF", "ABC") == 0);
+    cout << "  Test Case 4 (Match at Start): Passed" << endl;
+
+    // Test case 5: Multiple matches, last one wins
+    assert(KMPSearchLast("ABCXYZABCXY", "ABC") == 6);
+    cout << "  Test Case 5 (Multiple Matches): Passed" << endl;
+
+    // Test case 6: Overlapping matches
+    assert(KMPSearchLast("aaaaa", "aa") == 3);
+    assert(KMPSearchLast("ababab", "abab") == 2);
+    cout << "  Test Case 6 (Overlapping Matches): Passed" << endl;
+
+    // Test case 7: Complex case with resets, same as the forward search
+    assert(KMPSearchLast("ABABDABACDABABCABAB", "ABABCABAB") == 10);
+    assert(KMPSearchLast("aabaacaadaabaaba", "aaba") == 12);
+    cout << "  Test Case 7 (Complex): Passed" << endl;
+
+    cout << "KMPSearchLast tests finished." << endl << endl;
+}
+
+void testKMPSearchBitmap() {
+    cout << "Testing KMPSearchBitmap..." << endl;
+
+    // Test case 1: Empty text and empty pattern
+    MatchBitmap result1 = KMPSearchBitmap("", "ABC");
+    assert(result1.size == 0 && result1.words.empty());
+    MatchBitmap result1b = KMPSearchBitmap("ABCABC", "");
+    assert(result1b.size == 6 && countMatches(result1b) == 0);
+    cout << "  Test Case 1 (Empty Inputs): Passed" << endl;
+
+    // Test case 2: Bits mark the ends of overlapping matches
+    MatchBitmap result2 = KMPSearchBitmap("ababab", "abab");
+    vector<size_t> ends2;
+    forEachMatch(result2, [&](size_t i) { ends2.push_back(i); });
+    assert(ends2 == vector<size_t>({3, 5}));
+    assert(countMatches(result2) == 2);
+    assert(result2.test(3) && !result2.test(4));
+    cout << "  Test Case 2 (Overlapping Matches): Passed" << endl;
+
+    // Test case 3: Agrees with KMPSearch across several word boundaries
+    string text3;
+    for (int k = 0; k < 300; ++k) {
+        text3 += (k % 7 == 0 || k % 11 == 0) ? "ab" : "a";
+    }
+    string pattern3 = "aab";
+    vector<int> lps3 = KMPSearch(text3, pattern3);
+    MatchBitmap result3 = KMPSearchBitmap(text3, pattern3);
+    assert(result3.size == text3.length());
+    assert(result3.words.size() == (text3.length() + 63) / 64);
+    size_t expected_count3 = 0;
+    for (size_t i = 0; i < text3.length(); ++i) {
+        bool is_end = lps3[i] == (int)pattern3.length();
+        expected_count3 += is_end;
+        assert(result3.test(i) == is_end);
+    }
+    assert(countMatches(result3) == expected_count3);
+    cout << "  Test Case 3 (Matches KMPSearch, Multi-word): Passed" << endl;
+
+    // Test case 4: Match ending exactly on the last bit of a word
+    string text4 = string(61, 'x') + "abc" + "x";
+    MatchBitmap result4 = KMPSearchBitmap(text4, "abc");
+    assert(result4.test(63) && countMatches(result4) == 1);
+    cout << "  Test Case 4 (Word Boundary): Passed" << endl;
+
+    cout << "KMPSearchBitmap tests finished." << endl << endl;
+}
+
+void testEliasFanoMatches() {
+    cout << "Testing EliasFanoMatches..." << endl;
+
+    // Test case 1: Empty set
+    EliasFanoMatches empty(100, 10);
+    assert(empty.size() == 0 && empty.begin() == empty.end());
+    assert(empty.rank(50) == 0);
+    cout << "  Test Case 1 (Empty Set): Passed" << endl;
+
+    // Test case 2: Select, rank and iteration agree with a plain vector
+    vector<uint64_t> values2;
+    for (uint64_t v = 3; v < 100000; v += 1 + (v * 7919) % 37) {
+        values2.push_back(v);
+        if (v % 5 == 0) {
+            values2.push_back(v); // repeated values are allowed
+        }
+    }
+    EliasFanoMatches set2(100000, values2.size());
+    for (uint64_t v : values2) {
+        set2.push_back(v);
+    }
+    assert(set2.size() == values2.size());
+    assert(vector<uint64_t>(set2.begin(), set2.end()) == values2);
+    for (size_t k = 0; k < values2.size(); k += 97) {
+        assert(set2.select(k) == values2[k]);
+    }
+    assert(set2.select(values2.size() - 1) == values2.back());
+    for (uint64_t v : {uint64_t(0), uint64_t(3), uint64_t(4), uint64_t(500), uint64_t(99999), uint64_t(200000)}) {
+        size_t expected_rank = lower_bound(values2.begin(), values2.end(), v) - values2.begin();
+        assert(set2.rank(v) == expected_rank);
+    }
+    assert(set2.memoryBytes() < values2.size() * sizeof(uint64_t) / 4);
+    cout << "  Test Case 2 (Select/Rank/Iterate): Passed" << endl;
+
+    // Test case 3: KMPSearchEliasFano finds the same matches as KMPSearch
+    string text3 = "ABABDABACDABABCABABABABCABABXABABCABAB";
+    string pattern3 = "ABABCABAB";
+    vector<int> lps3 = KMPSearch(text3, pattern3);
+    vector<uint64_t> expected3;
+    for (size_t i = 0; i < text3.length(); ++i) {
+        if (lps3[i] == (int)pattern3.length()) {
+            expected3.push_back(i - pattern3.length() + 1);
+        }
+    }
+    EliasFanoMatches result3 = KMPSearchEliasFano(text3, pattern3);
+    assert(vector<uint64_t>(result3.begin(), result3.end()) == expected3);
+    assert(KMPSearchEliasFano(text3, "").empty());
+    cout << "  Test Case 3 (Matches KMPSearch): Passed" << endl;
+
+    // Test case 4: Dense pattern, merged from two overlapping shards
+    string text4(5000, 'a');
+    string pattern4 = "aaa";
+    EliasFanoMatches full4 = KMPSearchEliasFano(text4, pattern4);
+    assert(full4.size() == text4.length() - 2);
+    size_t split4 = 2500;
+    EliasFanoMatches left4 = KMPSearchEliasFano(text4.substr(0, split4 + 2), pattern4);
+    EliasFanoMatches right4(text4.length());
+    for (uint64_t offset : KMPSearchEliasFano(text4.substr(split4 - 2), pattern4)) {
+        right4.push_back(offset + split4 - 2);
+    }
+    EliasFanoMatches merged4 = EliasFanoMatches::merge(left4, right4);
+    assert(vector<uint64_t>(merged4.begin(), merged4.end()) == vector<uint64_t>(full4.begin(), full4.end()));
+    cout << "  Test Case 4 (Shard Merge): Passed" << endl;
+
+    cout << "EliasFanoMatches tests finished." << endl << endl;
+}
+
+void testKMPSearchRunLength() {
+    cout << "Testing KMPSearchRunLength..." << endl;
+
+    // Test case 1: Empty inputs
+    assert(KMPSearchRunLength("", "ABC").size() == 0);
+    assert(KMPSearchRunLength("ABCABC", "").size() == 0);
+    cout << "  Test Case 1 (Empty Inputs): Passed" << endl;
+
+    // Test case 2: Zeros and ramps collapse into runs
+    RunLengthProfile result2 = KMPSearchRunLength("XYZABCDEXYZ", "ABCDE");
+    assert(result2.expand() == vector<int>({0, 0, 0, 1, 2, 3, 4, 5, 0, 0, 0}));
+    assert(result2.runCount() == 3);
+    assert(result2[0] == 0 && result2[5] == 3 && result2[10] == 0);
+    cout << "  Test Case 2 (Zero and Ramp Runs): Passed" << endl;
+
+    // Test case 3: Same values as KMPSearch, including overlapping matches
+    vector<pair<string, string>> cases3 = {
+        {"ababab", "abab"},
+        {"ABABDABACDABABCABAB", "ABABCABAB"},
+        {"ABC", "ABCDE"},
+        {"aaaaaaaaaa", "aaa"},
+    };
+    for (const auto& [text, pattern] : cases3) {
+        vector<int> expected = KMPSearch(text, pattern);
+        RunLengthProfile result = KMPSearchRunLength(text, pattern);
+        assert(result.expand() == expected);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            assert(result[i] == expected[i]);
+        }
+    }
+    cout << "  Test Case 3 (Matches KMPSearch): Passed" << endl;
+
+    // Test case 4: Sparse matches in a long text stay small
+    string text4 = string(100000, 'x') + "needle" + string(100000, 'x');
+    RunLengthProfile result4 = KMPSearchRunLength(text4, "needle");
+    assert(result4.size() == text4.length());
+    assert(result4.runCount() == 3);
+    assert(result4[100005] == 6);
+    cout << "  Test Case 4 (Sparse Matches): Passed" << endl;
+
+    cout << "KMPSearchRunLength tests finished." << endl << endl;
+}
+
+void testCallerProvidedBuffers() {
+    cout << "Testing caller-provided buffers and PMR overloads..." << endl;
+
+    // Test case 1: computeLPS into a span leaves the tail of the buffer untouched
+    int buffer1[8];
+    fill(begin(buffer1), end(buffer1), -1);
+    computeLPS("AABAACAA", span<int>(buffer1, 8));
+    computeLPS("ABABAB", span<int>(buffer1, 8));
+    assert(vector<int>(buffer1, buffer1 + 6) == vector<int>({0, 0, 1, 2, 3, 4}));
+    assert(buffer1[6] == 1 && buffer1[7] == 2);
+    cout << "  Test Case 1 (computeLPS Span): Passed" << endl;
+
+    // Test case 2: KMPSearch into spans matches the vector overload
+    string text2 = "ABABDABACDABABCABAB";
+    string pattern2 = "ABABCABAB";
+    vector<int> scratch2(pattern2.length());
+    vector<int> out2(text2.length(), -1);
+    KMPSearch(text2, pattern2, scratch2, out2);
+    assert(out2 == KMPSearch(text2, pattern2));
+    assert(scratch2 == computeLPS(pattern2));
+    cout << "  Test Case 2 (KMPSearch Span): Passed" << endl;
+
+    // Test case 3: PMR overloads serve every allocation from the arena
+    alignas(max_align_t) char arena[4096];
+    pmr::monotonic_buffer_resource resource(arena, sizeof(arena), pmr::null_memory_resource());
+    pmr::vector<int> lps3 = computeLPS(pattern2, &resource);
+    pmr::vector<int> result3 = KMPSearch(text2, pattern2, &resource);
+    assert(vector<int>(lps3.begin(), lps3.end()) == computeLPS(pattern2));
+    assert(vector<int>(result3.begin(), result3.end()) == KMPSearch(text2, pattern2));
+    assert(KMPSearch(text2, "", &resource).empty());
+    cout << "  Test Case 3 (PMR Arena): Passed" << endl;
+
+    cout << "Caller-provided buffer tests finished." << endl << endl;
+}
+
+void testSearchWorkspace() {
+    cout << "Testing SearchWorkspace..." << endl;
+
+    // Test case 1: Workspace search matches KMPSearch
+    SearchWorkspace workspace;
+    string text1 = "ABABDABACDABABCABAB";
+    string pattern1 = "ABABCABAB";
+    span<const int> result1 = KMPSearch(workspace, text1, pattern1);
+    assert(vector<int>(result1.begin(), result1.end()) == KMPSearch(text1, pattern1));
+    assert(KMPSearch(workspace, text1, "").empty());
+    cout << "  Test Case 1 (Matches KMPSearch): Passed" << endl;
+
+    // Test case 2: No allocations after warm-up
+    KMPSearch(workspace, string(1000, 'a'), "aab");
+    size_t warm_allocations = workspace.allocations();
+    for (int k = 0; k < 100; ++k) {
+        KMPSearch(workspace, string(500 + k, 'a'), "aaab");
+    }
+    assert(workspace.allocations() == warm_allocations);
+    assert(workspace.highWater() == 1000);
+    cout << "  Test Case 2 (Steady State): Passed" << endl;
+
+    // Test case 3: A one-off large request is trimmed back once a full interval passes without it
+    SearchWorkspace trimmed({4, 16});
+    KMPSearch(trimmed, string(10000, 'x'), "xy");
+    assert(trimmed.capacity() >= 10000);
+    for (int k = 0; k < 8; ++k) {
+        KMPSearch(trimmed, "xxyxy", "xy");
+    }
+    assert(trimmed.capacity() <= 32);
+    span<const int> result3 = KMPSearch(trimmed, "xxyxy", "xy");
+    assert(vector<int>(result3.begin(), result3.end()) == KMPSearch("xxyxy", "xy"));
+    cout << "  Test Case 3 (Trim Policy): Passed" << endl;
+
+    // Test case 4: The thread-local workspace is reused by the same thread
+    assert(&threadLocalSearchWorkspace() == &threadLocalSearchWorkspace());
+    span<const int> result4 = KMPSearch(threadLocalSearchWorkspace(), "ababab", "abab");
+    assert(vector<int>(result4.begin(), result4.end()) == vector<int>({1, 2, 3, 4, 3, 4}));
+    cout << "  Test Case 4 (Thread-local Workspace): Passed" << endl;
+
+    // Test case 5: A trim never frees buffers a running search already holds
+    SearchWorkspace trimming({2, 16});
+    string pattern5 = string(5000, 'a') + "b";
+    KMPSearch(trimming, pattern5 + "a", pattern5);
+    for (int k = 0; k < 6; ++k) {
+        span<const int> result5 = KMPSearch(trimming, "aabaab", "aab");
+        assert(vector<int>(result5.begin(), result5.end()) == KMPSearch("aabaab", "aab"));
+    }
+    assert(trimming.capacity() <= 32);
+    cout << "  Test Case 5 (Trim Between Searches): Passed" << endl;
+
+    cout << "SearchWorkspace tests finished." << endl << endl;
+}
+
+void testCompiledPattern() {
+    cout << "Testing CompiledPattern..." << endl;
+
+    // Test case 1: Short patterns are stored inline
+    CompiledPattern short1("ABABCABAB");
+    assert(short1.isInline() && short1.length() == 9);
+    assert(!CompiledPattern(string(65, 'a')).isInline() && CompiledPattern(string(65, 'a')).isPacked());
+    assert(CompiledPattern(string(64, 'a')).isInline());
+    assert(alignof(CompiledPattern) >= 64 && sizeof(PackedPatternRecord) == 4);
+    cout << "  Test Case 1 (Inline Storage): Passed" << endl;
+
+    // Test case 2: Inline and heap patterns search like KMPSearch
+    string text2;
+    for (int k = 0; k < 50; ++k) {
+        text2 += string(k % 70, 'a') + "b";
+    }
+    for (int length : {1, 3, 63, 64, 65, 69}) {
+        string pattern = string(length - 1, 'a') + "b";
+        assert(KMPSearch(text2, CompiledPattern(pattern)) == KMPSearch(text2, pattern));
+    }
+    assert(KMPSearch("ABABDABACDABABCABAB", short1) == KMPSearch("ABABDABACDABABCABAB", "ABABCABAB"));
+    string wide2(PackedPatternRecord::kMaxLink + 1, 'a');
+    CompiledPattern compiled_wide2(wide2);
+    assert(!compiled_wide2.isInline() && !compiled_wide2.isPacked());
+    assert(KMPSearch(wide2 + "aba", compiled_wide2) == KMPSearch(wide2 + "aba", wide2));
+    cout << "  Test Case 2 (Matches KMPSearch): Passed" << endl;
+
+    // Test case 3: Empty pattern and empty text
+    assert(KMPSearch("ABC", CompiledPattern("")).empty());
+    assert(KMPSearch("", short1).empty());
+    cout << "  Test Case 3 (Empty Inputs): Passed" << endl;
+
+    cout << "CompiledPattern tests finished." << endl << endl;
+}
+
+void testKMPSearchHuge() {
+    cout << "Testing CompressedLPS and KMPSearchHuge..." << endl;
+
+    // Test case 1: Decoding reproduces computeLPS, including escaped drops
+    vector<string> patterns1 = {
+        "",
+        "A",
+        "AABAACAABAA",
+        randomText(1000, 2, 3),
+        string(300, 'a') + "b" + string(600, 'a'),
+        randomText(5000, 4, 5),
+    };
+    for (const string& pattern : patterns1) {
+        CompressedLPS compressed(pattern);
+        vector<int> lps = computeLPS(pattern);
+        assert(compressed.size() == lps.size());
+        for (size_t i = 0; i < lps.size(); ++i) {
+            assert(compressed[i] == lps[i]);
+        }
+    }
+    cout << "  Test Case 1 (Decode Matches computeLPS): Passed" << endl;
+
+    // Test case 2: The compressed table is much smaller than the int array
+    string pattern2 = randomText(100000, 2, 9);
+    CompressedLPS compressed2(pattern2);
+    assert(compressed2.memoryBytes() * 3 < pattern2.length() * sizeof(int));
+    cout << "  Test Case 2 (Compression): Passed" << endl;
+
+    // Test case 3: Matches agree with KMPSearch
+    string pattern3 = string(400, 'a') + "b" + string(400, 'a');
+    string text3 = pattern3 + string(300, 'a') + pattern3.substr(0, 700) + pattern3 + "b" + pattern3;
+    vector<int> lps3 = KMPSearch(text3, pattern3);
+    vector<size_t> expected3;
+    for (size_t i = 0; i < text3.length(); ++i) {
+        if (lps3[i] == (int)pattern3.length()) {
+            expected3.push_back(i - pattern3.length() + 1);
+        }
+    }
+    assert(expected3.size() >= 3);
+    assert(KMPSearchHuge(text3, pattern3, CompressedLPS(pattern3)) == expected3);
+    assert(KMPSearchHuge(text3, "", CompressedLPS("")).empty());
+    cout << "  Test Case 3 (Matches KMPSearch): Passed" << endl;
+
+    cout << "CompressedLPS and KMPSearchHuge tests finished." << endl << endl;
+}
+
+void testHugePageAllocator() {
+    cout << "Testing HugePageAllocator..." << endl;
+
+    // Test case 1: Small and large allocations round-trip
+    HugePageAllocator<int> allocator;
+    int* small = allocator.allocate(100);
+    small[99] = 7;
+    allocator.deallocate(small, 100);
+    size_t large_count = HugePageAllocator<int>::kHugePageSize;
+    int* large = allocator.allocate(large_count);
+#ifdef __linux__
+    assert(reinterpret_cast<uintptr_t>(large) % HugePageAllocator<int>::kHugePageSize == 0);
+#endif
+    large[0] = 1;
+    large[large_count - 1] = 2;
+    allocator.deallocate(large, large_count);
+    cout << "  Test Case 1 (Allocate/Deallocate): Passed" << endl;
+
+    // Test case 2: Huge page results match KMPSearch in both modes
+    string text2 = randomText(3 * 1024 * 1024, 2, 21);
+    string pattern2 = "abbab";
+    vector<int> expected2 = KMPSearch(text2, pattern2);
+    for (HugePageMode mode : {HugePageMode::Transparent, HugePageMode::Explicit}) {
+        HugePageVector<int> result = KMPSearch(text2, pattern2, HugePageAllocator<int>(mode));
+        assert(equal(result.begin(), result.end(), expected2.begin(), expected2.end()));
+    }
+    assert(KMPSearch(text2, "", HugePageAllocator<int>()).empty());
+    cout << "  Test Case 2 (Matches KMPSearch): Passed" << endl;
+
+    cout << "HugePageAllocator tests finished." << endl << endl;
+}
+
+void testZeroCopyEntryPoints() {
+    cout << "Testing string_view and byte span entry points..." << endl;
+
+    // Test case 1: Views into a larger buffer, without copies
+    const char* buffer1 = "xxABABDABACDABABCABABxx";
+    string_view text1(buffer1 + 2, 19);
+    string_view pattern1 = text1.substr(10, 9);
+    assert(pattern1 == "ABABCABAB");
+    assert(KMPSearch(text1, pattern1) == KMPSearch(string(text1), string(pattern1)));
+    assert(computeLPS(pattern1) == computeLPS(string(pattern1)));
+    cout << "  Test Case 1 (string_view): Passed" << endl;
+
+    // Test case 2: Byte spans
+    vector<byte> text2;
+    for (char c : string("ababab")) {
+        text2.push_back(static_cast<byte>(c));
+    }
+    span<const byte> pattern2 = span<const byte>(text2).first(4);
+    assert(KMPSearch(span<const byte>(text2), pattern2) == vector<int>({1, 2, 3, 4, 3, 4}));
+    assert(computeLPS(pattern2) == vector<int>({0, 0, 1, 2}));
+    cout << "  Test Case 2 (Byte Span): Passed" << endl;
+
+    // Test case 3: Embedded NUL bytes are ordinary characters
+    string text3("a\0ba\0b", 6);
+    string pattern3("a\0b", 3);
+    assert(KMPSearch(string_view(text3), string_view(pattern3)) == vector<int>({1, 2, 3, 1, 2, 3}));
+    cout << "  Test Case 3 (Embedded NUL): Passed" << endl;
+
+    cout << "string_view and byte span tests finished." << endl << endl;
+}
+
+void testKMPMatchView() {
+    cout << "Testing kmp_matches..." << endl;
+    static_assert(ranges::input_range<KMPMatchView>);
+    static_assert(ranges::view<KMPMatchView>);
+
+    // Test case 1: Empty pattern and no match
+    KMPMatchView empty1 = kmp_matches("ABCABC", "");
+    assert(empty1.begin() == empty1.end());
+    assert(ranges::distance(kmp_matches("ABCDEFG", "XYZ")) == 0);
+    cout << "  Test Case 1 (Empty Results): Passed" << endl;
+
+    // Test case 2: Overlapping matches, same as KMPSearch
+    string text2 = "ABABDABACDABABCABABABABCABAB";
+    string pattern2 = "ABAB";
+    vector<size_t> expected2;
+    vector<int> lps2 = KMPSearch(text2, pattern2);
+    for (size_t i = 0; i < lps2.size(); ++i) {
+        if (lps2[i] == (int)pattern2.length()) {
+            expected2.push_back(i + 1 - pattern2.length());
+        }
+    }
+    vector<size_t> result2;
+    for (size_t offset : kmp_matches(text2, pattern2)) {
+        result2.push_back(offset);
+    }
+    assert(result2 == expected2);
+    cout << "  Test Case 2 (Matches KMPSearch): Passed" << endl;
+
+    // Test case 3: Composes with take and filter
+    vector<size_t> result3;
+    for (size_t offset : kmp_matches(text2, pattern2) | views::filter([](size_t o) { return o % 2 == 0; }) |
+                             views::take(2)) {
+        result3.push_back(offset);
+    }
+    assert(result3 == vector<size_t>({0, 10}));
+    cout << "  Test Case 3 (take / filter): Passed" << endl;
+
+    // Test case 4: take stops scanning at the first match
+    string text4 = "needle" + string(1 << 20, 'x') + "needle";
+    auto first4 = kmp_matches(text4, "needle") | views::take(1);
+    vector<size_t> result4;
+    auto it4 = ranges::begin(first4);
+    for (; it4 != ranges::end(first4); ++it4) {
+        result4.push_back(*it4);
+    }
+    assert(result4 == vector<size_t>{0});
+    assert(it4.base().consumed() == 6);
+    cout << "  Test Case 4 (Early Exit): Passed" << endl;
+
+    cout << "kmp_matches tests finished." << endl << endl;
+}
+
+void testCoroutineScans() {
+    cout << "Testing coroutine match generator and async scan..." << endl;
+
+    string text = "ABABDABACDABABCABABABABCABAB";
+    string pattern = "ABABCABAB";
+    vector<size_t> expected;
+    for (size_t offset : kmp_matches(text, pattern)) {
+        expected.push_back(offset);
+    }
+    assert(expected.size() == 2);
+
+    // Test case 1: KMPStreamMatcher finds matches spanning chunk boundaries
+    KMPStreamMatcher matcher1(pattern);
+    vector<size_t> result1;
+    for (size_t start = 0; start < text.length(); start += 4) {
+        matcher1.feed(string_view(text).substr(start, 4), [&](size_t offset) { result1.push_back(offset); });
+    }
+    assert(result1 == expected);
+    assert(matcher1.consumed() == text.length());
+    cout << "  Test Case 1 (Stream Matcher): Passed" << endl;
+
+    // Test case 2: The generator reads chunks lazily
+    size_t position2 = 0;
+    int reads2 = 0;
+    ChunkReader reader2 = [&]() -> optional<string_view> {
+        if (position2 >= text.length()) {
+            return nullopt;
+        }
+        reads2++;
+        string_view chunk = string_view(text).substr(position2, 3);
+        position2 += 3;
+        return chunk;
+    };
+    MatchGenerator generator2 = kmpMatchGenerator(reader2, pattern);
+    auto it2 = generator2.begin();
+    assert(it2 != generator2.end() && *it2 == expected[0]);
+    assert(reads2 == 7); // the first match ends at offset 18
+    vector<size_t> result2 = {*it2};
+    for (++it2; it2 != generator2.end(); ++it2) {
+        result2.push_back(*it2);
+    }
+    assert(result2 == expected);
+    assert(generator2.begin() == generator2.end());
+    cout << "  Test Case 2 (Generator): Passed" << endl;
+
+    // Test case 3: Many async scans interleaved on one thread
+    const int scans = 100;
+    vector<ChunkChannel> channels(scans);
+    vector<vector<size_t>> results3(scans);
+    vector<ScanTask> tasks;
+    for (int k = 0; k < scans; ++k) {
+        tasks.push_back(asyncKMPScan(channels[k], pattern, [&results3, k](size_t offset) { results3[k].push_back(offset); }));
+    }
+    for (size_t start = 0; start < text.length(); start += 5) {
+        for (int k = 0; k < scans; ++k) {
+            channels[k].push(text.substr(start, 5));
+        }
+    }
+    for (int k = 0; k < scans; ++k) {
+        assert(!tasks[k].done());
+        channels[k].close();
+        assert(tasks[k].done());
+        tasks[k].rethrowIfFailed();
+        assert(results3[k] == expected);
+    }
+    cout << "  Test Case 3 (Interleaved Async Scans): Passed" << endl;
+
+    // Test case 4: Repeated begin() and moved-from handles
+    size_t position4 = 0;
+    ChunkReader reader4 = [&]() -> optional<string_view> {
+        if (position4 >= text.length()) {
+            return nullopt;
+        }
+        string_view chunk = string_view(text).substr(position4, 3);
+        position4 += 3;
+        return chunk;
+    };
+    MatchGenerator generator4 = kmpMatchGenerator(reader4, pattern);
+    auto it4 = generator4.begin();
+    assert(*it4 == expected[0] && *generator4.begin() == expected[0]);
+    ++it4;
+    assert(*generator4.begin() == expected[1]);
+    MatchGenerator moved4 = move(generator4);
+    assert(generator4.begin() == generator4.end());
+    assert(*moved4.begin() == expected[1]);
+    ChunkChannel channel4;
+    ScanTask task4 = asyncKMPScan(channel4, pattern, [](size_t) {});
+    ScanTask moved_task4 = move(task4);
+    assert(task4.done() && !moved_task4.done());
+    task4.rethrowIfFailed();
+    channel4.close();
+    assert(moved_task4.done());
+    cout << "  Test Case 4 (Single-Pass Handles): Passed" << endl;
+
+    cout << "Coroutine tests finished." << endl << endl;
+}
+
+void testAsyncSearch() {
+    cout << "Testing asyncSearch..." << endl;
+
+    // Test case 1: Small and large searches on the shared pool
+    string small1 = "ABABDABACDABABCABAB";
+    string large1 = randomText(100000, 2, 31);
+    AsyncSearch small_search = asyncSearch(small1, "ABABCABAB");
+    AsyncSearch large_search = asyncSearch(large1, "abbab");
+    assert(small_search.result.get() == vector<size_t>({10}));
+    vector<size_t> expected1;
+    for (size_t offset : kmp_matches(large1, "abbab")) {
+        expected1.push_back(offset);
+    }
+    assert(large_search.result.get() == expected1);
+    cout << "  Test Case 1 (Shared Pool): Passed" << endl;
+
+    // Test case 2: Small jobs are batched
+    SearchThreadPool pool(1, 1024, 64);
+    std::promise<void> release, running;
+    shared_future<void> released = release.get_future().share();
+    pool.submit([released, &running] {
+        running.set_value();
+        released.wait();
+    });
+    running.get_future().wait();
+    vector<AsyncSearch> searches2;
+    for (int k = 0; k < 100; ++k) {
+        searches2.push_back(asyncSearch(small1, "ABAB", pool));
+    }
+    release.set_value();
+    for (AsyncSearch& search : searches2) {
+        assert(search.result.get() == vector<size_t>({0, 10, 15}));
+    }
+    assert(pool.batchesRun() == 2);
+    cout << "  Test Case 2 (Batching): Passed" << endl;
+
+    // Test case 3: A search cancelled before it starts throws SearchCancelled
+    // The gate job must be running before the searches are submitted, or the worker could start
+    // cancelled3 before it is cancelled.
+    std::promise<void> release3, running3;
+    shared_future<void> released3 = release3.get_future().share();
+    pool.submit([released3, &running3] {
+        running3.set_value();
+        released3.wait();
+    });
+    running3.get_future().wait();
+    AsyncSearch cancelled3 = asyncSearch(large1, "abbab", pool);
+    AsyncSearch kept3 = asyncSearch(large1, "abbab", pool);
+    cancelled3.cancel();
+    release3.set_value();
+    bool threw3 = false;
+    try {
+        cancelled3.result.get();
+    } catch (const SearchCancelled&) {
+        threw3 = true;
+    }
+    assert(threw3);
+    assert(kept3.result.get() == expected1);
+    cout << "  Test Case 3 (Cancellation): Passed" << endl;
+
+    // Test case 4: Requests from many threads
+    SearchThreadPool pool4(4);
+    vector<thread> clients;
+    atomic<int> correct{0};
+    for (int t = 0; t < 8; ++t) {
+        clients.emplace_back([&] {
+            for (int k = 0; k < 50; ++k) {
+                if (asyncSearch(small1, "AB", pool4).result.get().size() == 7) {
+                    correct++;
+                }
+            }
+        });
+    }
+    for (thread& client : clients) {
+        client.join();
+    }
+    assert(correct == 400);
+    cout << "  Test Case 4 (Concurrent Clients): Passed" << endl;
+
+    // Test case 5: Jobs submitted from outside the pool run in submission order
+    vector<int> order5;
+    {
+        SearchThreadPool pool5(1);
+        std::promise<void> release5, running5;
+        shared_future<void> released5 = release5.get_future().share();
+        pool5.submit([released5, &running5] {
+            running5.set_value();
+            released5.wait();
+        });
+        running5.get_future().wait();
+        for (int k = 0; k < 5; ++k) {
+            pool5.submit([&order5, k] { order5.push_back(k); });
+        }
+        release5.set_value();
+    }
+    assert((order5 == vector<int>{0, 1, 2, 3, 4}));
+    cout << "  Test Case 5 (FIFO Submissions): Passed" << endl;
+
+    cout << "asyncSearch tests finished." << endl << endl;
+}
+
+void testScanLimits() {
+    cout << "Testing cancellation tokens and deadlines..." << endl;
+
+    string text = randomText(50000, 2, 41);
+    string pattern = "abbabab";
+    CompiledPattern compiled(pattern);
+    vector<int> expected = KMPSearch(text, pattern);
+
+    // Test case 1: No limits completes in one call
+    vector<int> lps1(text.length());
+    KMPScanState state1;
+    assert(KMPSearch(text, compiled, lps1, state1, ScanLimits()) == ScanStatus::Completed);
+    assert(state1.position == text.length() && lps1 == expected);
+    cout << "  Test Case 1 (No Limits): Passed" << endl;
+
+    // Test case 2: A past deadline stops at once; resuming finishes the scan
+    ScanLimits expired;
+    expired.deadline = chrono::steady_clock::now() - chrono::seconds(1);
+    vector<int> lps2(text.length());
+    KMPScanState state2;
+    assert(KMPSearch(text, compiled, lps2, state2, expired) == ScanStatus::DeadlineExceeded);
+    assert(state2.position == 0);
+    assert(KMPSearch(text, compiled, lps2, state2, ScanLimits()) == ScanStatus::Completed);
+    assert(lps2 == expected);
+    cout << "  Test Case 2 (Deadline and Resume): Passed" << endl;
+
+    // Test case 3: Cancelling from another thread keeps the partial result; resuming finishes it
+    string text3 = randomText(4 * 1024 * 1024, 2, 43);
+    vector<int> expected3 = KMPSearch(text3, pattern);
+    CancellationToken token3;
+    ScanLimits limits3;
+    limits3.token = &token3;
+    limits3.check_interval = 4096;
+    vector<int> lps3(text3.length());
+    KMPScanState state3;
+    thread canceller([&] { token3.cancel(); });
+    ScanStatus status3 = KMPSearch(text3, compiled, lps3, state3, limits3);
+    canceller.join();
+    if (status3 == ScanStatus::Cancelled) {
+        assert(state3.position % 4096 == 0 && state3.position < text3.length());
+        assert(equal(lps3.begin(), lps3.begin() + state3.position, expected3.begin()));
+        assert(KMPSearch(text3, compiled, lps3, state3, limits3) == ScanStatus::Cancelled);
+    }
+    assert(KMPSearch(text3, compiled, lps3, state3, ScanLimits()) == ScanStatus::Completed);
+    assert(lps3 == expected3);
+    cout << "  Test Case 3 (Cancel Mid-scan): Passed" << endl;
+
+    // Test case 4: Match-list scan with a stream matcher as resume state
+    vector<size_t> expected4;
+    for (size_t offset : kmp_matches(text, pattern)) {
+        expected4.push_back(offset);
+    }
+    KMPStreamMatcher matcher4(pattern);
+    vector<size_t> matches4;
+    CancellationToken token4;
+    token4.cancel();
+    ScanLimits limits4;
+    limits4.token = &token4;
+    assert(KMPScanWithLimits(matcher4, text, matches4, limits4) == ScanStatus::Cancelled);
+    assert(matches4.empty());
+    limits4.token = nullptr;
+    limits4.check_interval = 777;
+    assert(KMPScanWithLimits(matcher4, text, matches4, limits4) == ScanStatus::Completed);
+    assert(matches4 == expected4);
+    cout << "  Test Case 4 (Stream Matcher Resume): Passed" << endl;
+
+    cout << "Cancellation and deadline tests finished." << endl << endl;
+}
+
+void testMultiProcessSearch() {
+#ifdef __linux__
+    cout << "Testing multiProcessSearch..." << endl;
+
+    // Test case 1: Empty pattern, pattern longer than text
+    assert(multiProcessSearch("ABCABC", "", 4).empty());
+    assert(multiProcessSearch("ABC", "ABCDE", 4).empty());
+    cout << "  Test Case 1 (Empty Results): Passed" << endl;
+
+    // Test case 2: Same offsets as a sequential scan, for several worker counts
+    vector<pair<string, string>> cases2 = {
+        {randomText(200000, 2, 51), "abbabba"},
+        {string(10000, 'a'), "aaaa"},
+        {"ABABDABACDABABCABAB", "ABAB"},
+    };
+    for (const auto& [text, pattern] : cases2) {
+        vector<size_t> expected;
+        for (size_t offset : kmp_matches(text, pattern)) {
+            expected.push_back(offset);
+        }
+        for (unsigned workers : {1u, 3u, 8u, 64u}) {
+            assert(multiProcessSearch(text, pattern, workers) == expected);
+        }
+    }
+    cout << "  Test Case 2 (Matches Sequential Scan): Passed" << endl;
+
+    cout << "multiProcessSearch tests finished." << endl << endl;
+#endif
+}
+
+void testParallelKMPSearch() {
+    cout << "Testing OrderedMatchMerger and parallelKMPSearch..." << endl;
+
+    // Test case 1: Overlapping shards are merged in order without duplicates, with tiny buffers
+    vector<PatternMatch> merged1;
+    OrderedMatchMerger merger1({0, 50}, 2, [&](const PatternMatch& match) { merged1.push_back(match); });
+    thread producer1a([&] {
+        for (size_t offset = 0; offset < 100; offset += 2) {
+            merger1.push(0, {offset, 0});
+        }
+        merger1.finish(0);
+    });
+    thread producer1b([&] {
+        for (size_t offset = 50; offset < 150; offset += 2) {
+            merger1.push(1, {offset, 0});
+            merger1.push(1, {offset, 1});
+        }
+        merger1.finish(1);
+    });
+    merger1.run();
+    producer1a.join();
+    producer1b.join();
+    vector<PatternMatch> expected1;
+    for (size_t offset = 0; offset < 150; offset += 2) {
+        expected1.push_back({offset, 0});
+        if (offset >= 50) {
+            expected1.push_back({offset, 1});
+        }
+    }
+    assert(merged1 == expected1);
+    cout << "  Test Case 1 (Merge and Deduplicate): Passed" << endl;
+
+    // Test case 2: Parallel scan output is identical to a sequential scan with 64 workers
+    string text2 = randomText(50000, 2, 61);
+    vector<string> patterns2 = {"abba", "ab", "", "babbab", randomText(40, 2, 62)};
+    vector<PatternMatch> expected2;
+    for (size_t p = 0; p < patterns2.size(); ++p) {
+        for (size_t offset : kmp_matches(text2, patterns2[p])) {
+            expected2.push_back({offset, (int)p});
+        }
+    }
+    sort(expected2.begin(), expected2.end());
+    for (size_t chunk_size : {size_t(7), size_t(997), size_t(65536)}) {
+        ParallelScanConfig config;
+        config.workers = 64;
+        config.chunk_size = chunk_size;
+        config.buffer_capacity = 16;
+        vector<PatternMatch> result;
+        parallelKMPSearch(text2, patterns2, [&](const PatternMatch& match) { result.push_back(match); }, config);
+        assert(result == expected2);
+    }
+    cout << "  Test Case 2 (Matches Sequential Scan): Passed" << endl;
+
+    // Test case 3: Empty text
+    size_t count3 = 0;
+    parallelKMPSearch("", {"a"}, [&](const PatternMatch&) { count3++; });
+    assert(count3 == 0);
+    cout << "  Test Case 3 (Empty Text): Passed" << endl;
+
+    cout << "OrderedMatchMerger and parallelKMPSearch tests finished." << endl << endl;
+}
+
+void testParallelScanCalibration() {
+    cout << "Testing calibrateParallelScan and thread pinning..." << endl;
+
+    // Test case 1: Calibration stays within the allowed worker count and chunk bounds
+    string text1 = randomText(1 << 20, 4, 63);
+    vector<string> patterns1 = {"abcd", randomText(300, 4, 64)};
+    ParallelScanConfig config1 = calibrateParallelScan(text1, patterns1, 4);
+    assert(config1.workers >= 1 && config1.workers <= 4);
+    assert(config1.chunk_size >= 16 * 300);
+    cout << "  Test Case 1 (Calibrated Bounds): Passed" << endl;
+
+    // Test case 2: Pinned workers find the same matches as a sequential scan
+    config1.pin_threads = true;
+    vector<PatternMatch> pinned;
+    unsigned failures2 =
+        parallelKMPSearch(text1, patterns1, [&](const PatternMatch& match) { pinned.push_back(match); }, config1);
+    assert(failures2 <= config1.workers);
+    vector<PatternMatch> expected2;
+    for (size_t p = 0; p < patterns1.size(); ++p) {
+        for (size_t offset : kmp_matches(text1, patterns1[p])) {
+            expected2.push_back({offset, (int)p});
+        }
+    }
+    sort(expected2.begin(), expected2.end());
+    assert(pinned == expected2);
+    cout << "  Test Case 2 (Pinned Workers): Passed" << endl;
+
+    // Test case 3: Pinning a thread to a wrapped-around CPU index, where pinning is allowed
+    int error3 = -1;
+    thread([&] {
+        error3 = pinThreadToCpu(1000003);
+#ifdef __linux__
+        if (error3 == 0) {
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            assert(sched_getaffinity(0, sizeof(pinned), &pinned) == 0 && CPU_COUNT(&pinned) == 1);
+        }
+#endif
+    }).join();
+#ifdef __linux__
+    assert(error3 == 0 || error3 == EPERM || error3 == EINVAL);
+#else
+    assert(error3 == ENOSYS);
+#endif
+    // Where pinning is allowed, every worker of test case 2 was pinned, otherwise none was.
+    assert(error3 == 0 ? failures2 == 0 : failures2 == config1.workers);
+    cout << "  Test Case 3 (Pin Thread): Passed" << endl;
+
+    cout << "calibrateParallelScan and thread pinning tests finished." << endl << endl;
+}
+
+void testScheduledSearch() {
+    cout << "Testing SearchThreadPool::schedule and scheduleSearch..." << endl;
+    auto now = chrono::steady_clock::now();
+
+    // Test case 1: Interactive jobs run first, each class earliest deadline first
+    vector<string> order1;
+    {
+        SearchThreadPool pool1(1);
+        std::promise<void> gate1, running1;
+        shared_future<void> opened1 = gate1.get_future().share();
+        pool1.submit([opened1, &running1] {
+            running1.set_value();
+            opened1.wait();
+        });
+        // The worker must hold the gate job before anything is scheduled, or it could pick a
+        // scheduled job first.
+        running1.get_future().wait();
+        auto record1 = [&](string name) { return [&, name] { order1.push_back(name); }; };
+        pool1.schedule(record1("bulk late"), {JobPriority::Bulk, now + 3s});
+        pool1.schedule(record1("interactive late"), {JobPriority::Interactive, now + 5s});
+        pool1.schedule(record1("interactive early"), {JobPriority::Interactive, now + 1s});
+        pool1.schedule(record1("bulk early"), {JobPriority::Bulk, now + 1s});
+        pool1.schedule(record1("interactive no deadline"), {});
+        assert(pool1.interactiveWaiting() == 3);
+        gate1.set_value();
+    }
+    assert((order1 == vector<string>{"interactive early", "interactive late", "interactive no deadline",
+                                     "bulk early", "bulk late"}));
+    cout << "  Test Case 1 (Priority and Deadline Order): Passed" << endl;
+
+    // Test case 2: A bulk scan yields to an interactive job and still finds every match
+    SearchThreadPool pool2(1);
+    string text2 = randomText(32 << 20, 2, 65);
+    AsyncSearch bulk2 = scheduleSearch(text2, "abbab", {JobPriority::Bulk, now + 1s}, pool2, 64 * 1024);
+    this_thread::sleep_for(2ms);
+    std::promise<bool> bulk_done_first2;
+    pool2.schedule([&] { bulk_done_first2.set_value(bulk2.result.wait_for(0s) == future_status::ready); }, {});
+    assert(!bulk_done_first2.get_future().get());
+    vector<size_t> expected2;
+    for (size_t offset : kmp_matches(text2, "abbab")) {
+        expected2.push_back(offset);
+    }
+    assert(bulk2.result.get() == expected2);
+    cout << "  Test Case 2 (Bulk Preemption): Passed" << endl;
+
+    // Test case 3: Interactive scheduled search, and a cancelled bulk search
+    AsyncSearch interactive3 = scheduleSearch("abcabcab", "abc", {}, pool2);
+    assert((interactive3.result.get() == vector<size_t>{0, 3}));
+    std::promise<void> gate3;
+    shared_future<void> opened3 = gate3.get_future().share();
+    pool2.submit([opened3] { opened3.wait(); });
+    AsyncSearch cancelled3 = scheduleSearch(text2, "abbab", {JobPriority::Bulk}, pool2);
+    cancelled3.cancel();
+    gate3.set_value();
+    bool threw3 = false;
+    try {
+        cancelled3.result.get();
+    } catch (const SearchCancelled&) {
+        threw3 = true;
+    }
+    assert(threw3);
+    cout << "  Test Case 3 (Interactive and Cancelled Searches): Passed" << endl;
+
+    cout << "SearchThreadPool::schedule and scheduleSearch tests finished." << endl << endl;
+}
+
+void testSearchCostModel() {
+    cout << "Testing patternPeriod and SearchCostModel..." << endl;
+
+    // Test case 1: Smallest pattern periods
+    assert(patternPeriod("abcabcab") == 3);
+    assert(patternPeriod("aaaa") == 1);
+    assert(patternPeriod("abcd") == 4);
+    assert(patternPeriod("") == 0);
+    cout << "  Test Case 1 (Pattern Period): Passed" << endl;
+
+    // Test case 2: Estimates follow the linear model and interpolate by periodicity
+    array<SearchCostModel::EngineCost, 4> costs2;
+    costs2[size_t(SearchEngine::Standard)] = {2.0, 1.0, 3.0};
+    SearchCostModel model2(costs2);
+    assert(model2.estimateMilliseconds(1000000, 1000, 1000, SearchEngine::Standard) == 1.002);
+    assert(model2.estimateMilliseconds(1000000, 4, 2, SearchEngine::Standard) == 2.000008);
+    assert(model2.estimateMilliseconds(1000000, "aaaa", SearchEngine::Standard) ==
+           model2.estimateMilliseconds(1000000, 4, 1, SearchEngine::Standard));
+    assert(model2.estimateMilliseconds(1000000, "", SearchEngine::Standard) == 0);
+    costs2[size_t(SearchEngine::Compiled)] = {2.0, 1.0, 3.0, 0.5};
+    assert(SearchCostModel(costs2).estimateMilliseconds(1000000, 1000, 1000, SearchEngine::Compiled) == 1.502);
+    cout << "  Test Case 2 (Linear Model): Passed" << endl;
+
+    // Test case 3: Calibrated costs are positive and grow with the text
+    SearchCostModel model3 = SearchCostModel::calibrate(1 << 16);
+    for (SearchEngine engine : {SearchEngine::Standard, SearchEngine::Compiled, SearchEngine::Compressed,
+                                SearchEngine::Streaming}) {
+        const SearchCostModel::EngineCost& cost = model3.cost(engine);
+        assert(cost.setup_ns_per_pattern_byte > 0 && cost.typical_ns_per_text_byte > 0 && cost.worst_ns_per_text_byte > 0);
+        assert(model3.estimateMilliseconds(2000, "abcab", engine) < model3.estimateMilliseconds(4000, "abcab", engine));
+    }
+    assert(model3.cost(SearchEngine::Standard).output_ns_per_text_byte > 0);
+    assert(model3.cost(SearchEngine::Streaming).output_ns_per_text_byte == 0);
+    cout << "  Test Case 3 (Calibration): Passed" << endl;
+
+    cout << "patternPeriod and SearchCostModel tests finished." << endl << endl;
+}
+
+void testKMPCountApproximate() {
+    cout << "Testing KMPCountApproximate..." << endl;
+
+    // Test case 1: Sampling every block gives the exact count, including matches across blocks
+    string text1 = randomText(100000, 2, 71);
+    size_t exact1 = countMatches(KMPSearchBitmap(text1, "abbab"));
+    ApproximateCount count1 = KMPCountApproximate(text1, "abbab", 2000, 97);
+    assert(count1.exact() && count1.estimate == exact1 && count1.lower == exact1 && count1.upper == exact1);
+    cout << "  Test Case 1 (All Blocks): Passed" << endl;
+
+    // Test case 2: The 95% interval covers the true count for most samples
+    string text2 = randomText(1 << 22, 4, 72);
+    double exact2 = countMatches(KMPSearchBitmap(text2, "abca"));
+    int covered2 = 0;
+    for (uint64_t seed = 1; seed <= 40; ++seed) {
+        ApproximateCount count2 = KMPCountApproximate(text2, "abca", 64, 4096, seed);
+        assert(count2.sampled_blocks == 64 && count2.total_blocks == 1024 && !count2.exact());
+        assert(count2.lower <= count2.estimate && count2.estimate <= count2.upper);
+        covered2 += count2.lower <= exact2 && exact2 <= count2.upper;
+    }
+    assert(covered2 >= 34);
+    cout << "  Test Case 2 (Confidence Interval): Passed" << endl;
+
+    // Test case 3: Empty pattern, and a pattern longer than the text
+    assert(KMPCountApproximate("abc", "", 4).estimate == 0);
+    assert(KMPCountApproximate("abc", "abcd", 4).total_blocks == 0);
+    cout << "  Test Case 3 (Edge Cases): Passed" << endl;
+
+    cout << "KMPCountApproximate tests finished." << endl << endl;
+}
+
+void testWindowedMatchCounter() {
+    cout << "Testing SlidingWindowCounter and WindowedMatchCounter..." << endl;
+
+    // Test case 1: Buckets expire as the window moves, late events inside the window still count
+    SlidingWindowCounter counter1(2, 100, 10);
+    assert(counter1.bucketWidth() == 10);
+    counter1.add(0, 5);
+    counter1.add(0, 55);
+    counter1.add(1, 99);
+    counter1.add(0, 30);
+    assert(counter1.count(0) == 3 && counter1.count(1) == 1);
+    counter1.advance(105);
+    assert(counter1.count(0) == 2 && counter1.count(1) == 1);
+    counter1.add(1, 2);
+    assert(counter1.count(1) == 1);
+    counter1.advance(10000);
+    assert(counter1.count(0) == 0 && counter1.count(1) == 0);
+    cout << "  Test Case 1 (Ring Buckets): Passed" << endl;
+
+    // Test case 2: Byte windows match a direct count over the last window, across chunk boundaries
+    string text2 = randomText(20000, 2, 81);
+    vector<string> patterns2 = {"abba", "ab"};
+    WindowedMatchCounter counter2(patterns2, WindowUnit::Bytes, 1000, 10);
+    for (size_t start = 0; start < text2.length(); start += 333) {
+        counter2.feed(text2.substr(start, 333));
+        size_t end = min(text2.length(), start + 333);
+        long window_start = ((long)(end - 1) / 100 - 9) * 100; // first byte of the oldest bucket
+        for (size_t p = 0; p < patterns2.size(); ++p) {
+            uint64_t expected = 0;
+            for (size_t offset : kmp_matches(string_view(text2).substr(0, end), patterns2[p])) {
+                expected += long(offset + patterns2[p].length() - 1) >= window_start;
+            }
+            assert(counter2.count(p) == expected);
+        }
+    }
+    cout << "  Test Case 2 (Byte Window): Passed" << endl;
+
+    // Test case 3: Time windows count matches by feed time and expire when idle
+    auto now = chrono::steady_clock::now();
+    WindowedMatchCounter counter3({"error"}, WindowUnit::Milliseconds, 1000, 10);
+    counter3.feed("error error", now);
+    counter3.feed("no error", now + 500ms);
+    assert(counter3.count(0) == 3);
+    counter3.advance(now + 1200ms);
+    assert(counter3.count(0) == 1);
+    counter3.advance(now + 2000ms);
+    assert(counter3.count(0) == 0 && counter3.consumed() == 19);
+    cout << "  Test Case 3 (Time Window): Passed" << endl;
+
+    cout << "SlidingWindowCounter and WindowedMatchCounter tests finished." << endl << endl;
+}
+
 void runComputeLPSSample() {
     string pattern = "AABAACAABAA";
     vector<int> lps = computeLPS(pattern);
@@ -237,10 +4165,168 @@ void runKMPSearchSample() {
     cout << endl;
 }
 
+void runCompiledPatternBenchmark() {
+    // The pattern is larger than L1, and the text is made of copies of it with sparse
+    // mutations, so the search reaches deep pattern states and falls back from them.
+    string pattern = randomText(256 * 1024, 2, 7);
+    string text;
+    mt19937_64 generator(11);
+    while (text.length() < 4 * 1024 * 1024) {
+        string copy = pattern;
+        for (size_t k = 0; k < copy.length(); k += 4096) {
+            copy[(k + generator() % 4096) % copy.length()] = 'c';
+        }
+        text += copy;
+    }
+    vector<int> lps(text.length());
+    vector<int> lps_pattern = computeLPS(pattern);
+    CompiledPattern compiled(pattern);
+    double separate = measureMilliseconds([&] {
+        KMPSearchWithTable(text, pattern.data(), lps_pattern.data(), pattern.length(), lps);
+    });
+    double interleaved = measureMilliseconds([&] { KMPSearch(text, compiled, lps); });
+    cout << "Benchmark (256 KiB pattern, 4 MiB text):" << endl;
+    cout << "  separate pattern/LPS arrays: " << separate << " ms" << endl;
+    cout << "  interleaved pattern records: " << interleaved << " ms" << endl;
+}
+
+void runCostModelBenchmark() {
+    string text = randomText(16 * 1024 * 1024, 2, 31);
+    SearchCostModel model = SearchCostModel::calibrate(text.length());
+    cout << "Benchmark (search cost estimates, 16 MiB text):" << endl;
+    for (string pattern : {randomText(64, 2, 37), string(64, 'a')}) {
+        double estimate = model.estimateMilliseconds(text.length(), pattern, SearchEngine::Standard);
+        double measured = measureMilliseconds([&] { KMPSearch(text, pattern); });
+        cout << "  period " << patternPeriod(pattern) << " pattern: estimated " << estimate << " ms, measured "
+             << measured << " ms (" << showpos << int(round((estimate / measured - 1) * 100)) << noshowpos
+             << "%)" << endl;
+    }
+}
+
+void runHugePatternBenchmark() {
+    string pattern = randomText(4 * 1024 * 1024, 2, 13);
+    string text;
+    mt19937_64 generator(17);
+    while (text.length() < 8 * 1024 * 1024) {
+        string copy = pattern;
+        for (size_t k = 0; k < copy.length(); k += 65536) {
+            copy[(k + generator() % 65536) % copy.length()] = 'c';
+        }
+        text += copy;
+    }
+    vector<int> lps_pattern = computeLPS(pattern);
+    CompressedLPS compressed(pattern);
+    vector<int> lps(text.length());
+    double full = measureMilliseconds([&] {
+        KMPSearchWithTable(text, pattern.data(), lps_pattern.data(), pattern.length(), lps);
+    }, 1);
+    double compact = measureMilliseconds([&] { KMPSearchHuge(text, pattern, compressed); }, 1);
+    cout << "Benchmark (4 MiB pattern, 8 MiB text):" << endl;
+    cout << "  int LPS table (" << lps_pattern.size() * sizeof(int) / 1024 << " KiB): " << full << " ms" << endl;
+    cout << "  compressed LPS table (" << compressed.memoryBytes() / 1024 << " KiB): " << compact << " ms" << endl;
+}
+
+/**
+ * @brief Counts dTLB load misses of the calling thread, where perf events are available.
+ */
+class DTLBMissCounter {
+public:
+    DTLBMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~DTLBMissCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    bool available() const { return fd_ >= 0; }
+
+    /**
+     * @brief Runs f and returns the number of dTLB load misses it caused, or -1 if unavailable.
+     */
+    template <class F>
+    long long measure(F&& f) {
+        if (!available()) {
+            f();
+            return -1;
+        }
+        long long count = 0;
+#ifdef __linux__
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        f();
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+            count = -1;
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+void runHugePageBenchmark() {
+    string text = randomText(16 * 1024 * 1024, 4, 23);
+    string pattern = "abcab";
+    DTLBMissCounter counter;
+    double regular_ms = 0, huge_ms = 0;
+    long long regular_misses = counter.measure([&] {
+        regular_ms = measureMilliseconds([&] { KMPSearch(text, pattern); }, 1);
+    });
+    long long huge_misses = counter.measure([&] {
+        huge_ms = measureMilliseconds([&] { KMPSearch(text, pattern, HugePageAllocator<int>()); }, 1);
+    });
+    cout << "Benchmark (16 MiB text, 64 MiB per-position result):" << endl;
+    cout << "  std::allocator: " << regular_ms << " ms, dTLB load misses: ";
+    cout << (regular_misses >= 0 ? to_string(regular_misses) : "n/a") << endl;
+    cout << "  HugePageAllocator: " << huge_ms << " ms, dTLB load misses: ";
+    cout << (huge_misses >= 0 ? to_string(huge_misses) : "n/a") << endl;
+}
+
 int main() {
     testComputeLPS();
     testKMPSearch();
+    testKMPSearchLast();
+    testKMPSearchBitmap();
+    testEliasFanoMatches();
+    testKMPSearchRunLength();
+    testCallerProvidedBuffers();
+    testSearchWorkspace();
+    testCompiledPattern();
+    testKMPSearchHuge();
+    testHugePageAllocator();
+    testZeroCopyEntryPoints();
+    testKMPMatchView();
+    testCoroutineScans();
+    testAsyncSearch();
+    testScanLimits();
+    testMultiProcessSearch();
+    testParallelKMPSearch();
+    testParallelScanCalibration();
+    testScheduledSearch();
+    testSearchCostModel();
+    testKMPCountApproximate();
+    testWindowedMatchCounter();
     runComputeLPSSample();
     runKMPSearchSample();
+    runCompiledPatternBenchmark();
+    runHugePatternBenchmark();
+    runHugePageBenchmark();
+    runCostModelBenchmark();
     return 0;
 }
\ No newline at end of file
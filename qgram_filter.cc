@@ -0,0 +1,649 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief A match of one pattern out of a set, ordered by offset and then by pattern id.
+ */
+struct PatternMatch {
+    size_t offset;
+    int pattern_id;
+
+    auto operator<=>(const PatternMatch&) const = default;
+};
+
+/**
+ * @brief Finalizer of splitmix64, a cheap mixing of all 64 input bits.
+ */
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111eb;
+    x ^= x >> 31;
+    return x;
+}
+
+/**
+ * @brief Blocked Bloom filter over 64-bit keys: all probes of a key fall in one 64-bit word.
+ *
+ * A standard Bloom filter touches k random cache lines per lookup; here the word is chosen by
+ * the high bits of the mixed key and its k bits by the low bits, which pick one of a table of
+ * precomputed k-bit masks and a rotation of it, so a lookup is two loads and a mask test
+ * whatever k is. Rotations make 64 times more distinct masks than the table holds, so two keys
+ * rarely share a whole mask. Blocking costs a slightly higher false-positive rate than an
+ * unblocked filter of the same size, for a lookup that is a single access outside the
+ * L1-resident mask table.
+ */
+class BlockedBloomFilter {
+public:
+    /**
+     * @param keys The number of keys to be inserted.
+     * @param bits_per_key Filter bits per key, trading memory for the false-positive rate.
+     */
+    BlockedBloomFilter(size_t keys, double bits_per_key) {
+        bits_per_key = max(bits_per_key, 1.0);
+        size_t words = max<size_t>(ceil(keys * bits_per_key / 64), 1);
+        words_.assign(words, 0);
+        bits_per_key_ = double(words * 64) / max<size_t>(keys, 1);
+        // Blocking favours fewer probes than the unblocked optimum b ln 2, so search for it.
+        for (int probes = 2; probes <= 8; ++probes) {
+            if (falsePositiveRate(bits_per_key_, probes) < falsePositiveRate(bits_per_key_, probes_)) {
+                probes_ = probes;
+            }
+        }
+        // Each mask sets the bits of probes_ successive 6-bit slices of a mixed index.
+        masks_.resize(kMasks);
+        for (size_t index = 0; index < kMasks; ++index) {
+            uint64_t slices = mix64(index + 0x5bd1e995);
+            for (int k = 0; k < probes_; ++k) {
+                masks_[index] |= uint64_t(1) << (slices >> (6 * k) & 63);
+            }
+        }
+    }
+
+    void insert(uint64_t key) {
+        uint64_t hash = mix64(key);
+        words_[wordIndex(hash)] |= mask(hash);
+    }
+
+    bool mayContain(uint64_t key) const {
+        uint64_t hash = mix64(key);
+        uint64_t bits = mask(hash);
+        return (words_[wordIndex(hash)] & bits) == bits;
+    }
+
+    size_t memoryBytes() const { return words_.size() * sizeof(uint64_t); }
+    int probes() const { return probes_; }
+
+    /**
+     * @brief The expected false-positive rate, averaged over the Poisson number of keys per word.
+     *
+     * A word holding j keys has about 64 (1 - (1 - 1/64)^(k j)) bits set; the variance of j is
+     * why blocking costs accuracy compared to (1 - e^(-k/b))^k for an unblocked filter.
+     */
+    double expectedFalsePositiveRate() const { return falsePositiveRate(bits_per_key_, probes_); }
+
+private:
+    static double falsePositiveRate(double bits_per_key, int probes) {
+        double load = 64 / bits_per_key; // mean keys per word
+        double rate = 0, poisson = exp(-load);
+        for (int j = 0; j < 64 * 4 + 4 * load; ++j) {
+            rate += poisson * pow(1 - pow(1 - 1.0 / 64, probes * j), probes);
+            poisson *= load / (j + 1);
+        }
+        return rate;
+    }
+
+    // The high half of the hash scaled to the word count, so any filter size is usable.
+    size_t wordIndex(uint64_t hash) const { return (hash >> 32) * words_.size() >> 32; }
+
+    static constexpr size_t kMasks = 1024;
+
+    uint64_t mask(uint64_t hash) const { return rotl(masks_[hash % kMasks], hash / kMasks % 64); }
+
+    vector<uint64_t> words_;
+    vector<uint64_t> masks_; // k-bit masks indexed by the low bits of the hash
+    int probes_ = 1;
+    double bits_per_key_ = 0; // actual bits per key after rounding the size up
+};
+
+constexpr uint64_t kHashBase = 0x100000001b3; // odd, so powers of the base stay odd modulo 2^64
+
+/**
+ * @brief Polynomial hash of a string modulo 2^64: s[0] * B^(m-1) + ... + s[m-1].
+ */
+uint64_t polynomialHash(string_view s) {
+    uint64_t hash = 0;
+    for (char c : s) {
+        hash = hash * kHashBase + (unsigned char)c;
+    }
+    return hash;
+}
+
+/**
+ * @brief Pattern ids grouped by a 64-bit key, with an open-addressing index from key to group.
+ */
+class PatternGroups {
+public:
+    struct Group {
+        uint64_t key;
+        uint32_t begin, end; // range of ids() whose patterns have this key
+    };
+
+    PatternGroups() = default;
+
+    /**
+     * @param keys keys[k] is the key of pattern ids[k]; ids are kept in order within a group.
+     */
+    PatternGroups(const vector<uint64_t>& keys, const vector<uint32_t>& ids) : ids_(ids) {
+        vector<uint32_t> order(ids.size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+        for (size_t k = 0; k < order.size(); ++k) {
+            ids_[k] = ids[order[k]];
+            if (k == 0 || keys[order[k]] != keys[order[k - 1]]) {
+                groups_.push_back({keys[order[k]], (uint32_t)k, (uint32_t)k});
+            }
+            groups_.back().end++;
+        }
+        size_t capacity = bit_ceil(max<size_t>(2 * groups_.size(), 16));
+        slot_shift_ = 64 - countr_zero(capacity);
+        slots_.assign(capacity, kEmpty);
+        for (size_t g = 0; g < groups_.size(); ++g) {
+            size_t index = slotIndex(groups_[g].key);
+            while (slots_[index] != kEmpty) {
+                index = (index + 1) & (slots_.size() - 1);
+            }
+            slots_[index] = g;
+        }
+    }
+
+    const Group* find(uint64_t key) const {
+        for (size_t index = slotIndex(key); slots_[index] != kEmpty; index = (index + 1) & (slots_.size() - 1)) {
+            if (groups_[slots_[index]].key == key) {
+                return &groups_[slots_[index]];
+            }
+        }
+        return nullptr;
+    }
+
+    span<const uint32_t> ids(const Group& group) const {
+        return span<const uint32_t>(ids_).subspan(group.begin, group.end - group.begin);
+    }
+
+    const vector<Group>& groups() const { return groups_; }
+
+private:
+    static constexpr uint32_t kEmpty = numeric_limits<uint32_t>::max();
+
+    size_t slotIndex(uint64_t key) const { return (key * 0x9e3779b97f4a7c15) >> slot_shift_; }
+
+    vector<uint32_t> ids_;   // pattern ids sorted by key
+    vector<Group> groups_;   // one per distinct key
+    vector<uint32_t> slots_ = vector<uint32_t>(1, kEmpty); // group indexes
+    int slot_shift_ = 63;
+};
+
+/**
+ * @brief Multi-pattern matcher for very large pattern sets with a Bloom prefilter.
+ *
+ * Patterns of at least kMinFingerprint bytes are split into length classes [2^k, 2^(k+1)), and
+ * each pattern is fingerprinted by the polynomial hash of its first m bytes, m being the
+ * shortest length in its class, so a fingerprint covers at least half of its pattern and a
+ * single short pattern does not shorten the fingerprints of longer ones. The scan rolls one
+ * hash per class over the text and looks each window up in a BlockedBloomFilter of all
+ * fingerprints, which at 8 to 16 bits per pattern stays far smaller than any automaton over the
+ * same set. Only windows that pass the filter reach the exact stage: a table from fingerprint
+ * to the patterns with it, whose full bytes are compared at the offset. Hashing whole prefixes
+ * rather than a fixed q-gram keeps groups small when many patterns share a prefix such as
+ * "https://". Lowering bits_per_pattern shrinks the filter and lets more windows through to
+ * the exact stage; 0 disables the filter. Results are exact either way.
+ *
+ * Shorter patterns would make fingerprints unselective, so they take their own path: a bitmap
+ * of their first two bytes gates a lookup of each short length present, keyed by the exact
+ * bytes.
+ */
+class QGramFilterMatcher {
+public:
+    static constexpr size_t kMinFingerprint = 8;
+
+    /**
+     * @param patterns The patterns; at least one byte each.
+     * @param bits_per_pattern Filter bits per distinct fingerprint; 0 for no filter.
+     * @throws invalid_argument if a pattern is empty.
+     */
+    explicit QGramFilterMatcher(const vector<string>& patterns, double bits_per_pattern = 12)
+        : patterns_(patterns), filter_(0, 1), use_filter_(bits_per_pattern > 0) {
+        vector<uint32_t> short_ids;
+        vector<vector<uint32_t>> class_ids(numeric_limits<size_t>::digits + 1); // by bit width
+        for (size_t id = 0; id < patterns_.size(); ++id) {
+            size_t length = patterns_[id].length();
+            if (length == 0) {
+                throw invalid_argument("QGramFilterMatcher: patterns must not be empty");
+            }
+            if (length >= kMinFingerprint) {
+                class_ids[bit_width(length)].push_back(id);
+            } else {
+                short_ids.push_back(id);
+            }
+        }
+
+        vector<uint64_t> fingerprints;
+        vector<uint32_t> long_ids;
+        for (const vector<uint32_t>& ids : class_ids) {
+            if (ids.empty()) {
+                continue;
+            }
+            LengthClass& length_class = classes_.emplace_back();
+            length_class.m = patterns_[ids[0]].length();
+            for (uint32_t id : ids) {
+                length_class.m = min(length_class.m, patterns_[id].length());
+            }
+            length_class.salt = mix64(length_class.m);
+            uint64_t power = 1;
+            for (size_t k = 0; k < length_class.m; ++k) {
+                power *= kHashBase;
+            }
+            for (int c = 0; c < 256; ++c) {
+                length_class.outgoing[c] = c * power;
+            }
+            for (uint32_t id : ids) {
+                string_view prefix = string_view(patterns_[id]).substr(0, length_class.m);
+                fingerprints.push_back(polynomialHash(prefix) + length_class.salt);
+                long_ids.push_back(id);
+            }
+        }
+        long_groups_ = PatternGroups(fingerprints, long_ids);
+        filter_ = BlockedBloomFilter(long_groups_.groups().size(), max(bits_per_pattern, 1.0));
+        for (const PatternGroups::Group& group : long_groups_.groups()) {
+            filter_.insert(group.key);
+        }
+
+        vector<uint64_t> short_keys;
+        short_lead_.assign(65536 / 64, 0);
+        for (uint32_t id : short_ids) {
+            const string& pattern = patterns_[id];
+            short_keys.push_back(shortKey(pattern.data(), pattern.length()));
+            if (find(short_lengths_.begin(), short_lengths_.end(), pattern.length()) == short_lengths_.end()) {
+                short_lengths_.push_back(pattern.length());
+            }
+            unsigned lead = (unsigned char)pattern[0];
+            for (unsigned next = 0; next < 256; ++next) {
+                if (pattern.length() == 1 || next == (unsigned char)pattern[1]) {
+                    short_lead_[(lead | next << 8) / 64] |= uint64_t(1) << ((lead | next << 8) % 64);
+                }
+            }
+        }
+        sort(short_lengths_.begin(), short_lengths_.end());
+        short_groups_ = PatternGroups(short_keys, short_ids);
+    }
+
+    /**
+     * @brief Calls on_match(offset, pattern_id) for every match, by offset and then by id.
+     */
+    template <class F>
+    void forEachMatch(string_view text, F&& on_match) const {
+        const char* s = text.data();
+        vector<uint32_t> found; // matches at one offset, from every path
+        scan(text, [&](size_t offset, span<const PatternGroups::Group* const> groups) {
+            found.clear();
+            for (const PatternGroups::Group* group : groups) {
+                for (uint32_t id : long_groups_.ids(*group)) {
+                    const string& pattern = patterns_[id];
+                    if (pattern.length() <= text.length() - offset &&
+                        memcmp(s + offset, pattern.data(), pattern.length()) == 0) {
+                        found.push_back(id);
+                    }
+                }
+            }
+            for (size_t length : short_lengths_) {
+                if (length > text.length() - offset) {
+                    break;
+                }
+                if (const PatternGroups::Group* short_group = short_groups_.find(shortKey(s + offset, length))) {
+                    span<const uint32_t> ids = short_groups_.ids(*short_group);
+                    found.insert(found.end(), ids.begin(), ids.end());
+                }
+            }
+            if (found.size() > 1) {
+                sort(found.begin(), found.end());
+            }
+            for (uint32_t id : found) {
+                on_match(offset, (int)id);
+            }
+        });
+    }
+
+    vector<PatternMatch> search(string_view text) const {
+        vector<PatternMatch> matches;
+        forEachMatch(text, [&](size_t offset, int id) { matches.push_back({offset, id}); });
+        return matches;
+    }
+
+    /**
+     * @brief Returns the number of text offsets that pass the filter, for tuning bits per pattern.
+     */
+    size_t countCandidates(string_view text) const {
+        size_t candidates = 0;
+        scan(text, [&](size_t, span<const PatternGroups::Group* const>) { candidates++; }, false);
+        return candidates;
+    }
+
+    /**
+     * @brief Returns the bytes hashed per fingerprint in each length class, increasing.
+     */
+    vector<size_t> fingerprintLengths() const {
+        vector<size_t> lengths;
+        for (const LengthClass& length_class : classes_) {
+            lengths.push_back(length_class.m);
+        }
+        return lengths;
+    }
+
+    size_t filterBytes() const { return use_filter_ ? filter_.memoryBytes() : 0; }
+    double expectedFalsePositiveRate() const { return use_filter_ ? filter_.expectedFalsePositiveRate() : 1; }
+
+private:
+    static constexpr size_t kMaxClasses = 64;
+
+    struct LengthClass {
+        size_t m;                // bytes hashed per fingerprint: the shortest length in the class
+        uint64_t salt;           // added to fingerprints so equal hashes of two classes differ
+        uint64_t outgoing[256];  // c * B^m for every byte value c
+    };
+
+    /**
+     * @brief Calls on_candidate(offset, groups) for every offset where a window passes the
+     *        filter or the first two bytes start a short pattern. If exact, groups are the
+     *        fingerprint groups of the windows; otherwise only filter passes are reported,
+     *        with no groups.
+     */
+    template <class F>
+    void scan(string_view text, F&& on_candidate, bool exact = true) const {
+        const unsigned char* s = (const unsigned char*)text.data();
+        size_t n = text.length();
+        bool short_path = exact && !short_lengths_.empty();
+        array<uint64_t, kMaxClasses> hashes;
+        array<const PatternGroups::Group*, kMaxClasses> groups;
+        size_t active = 0; // classes, by increasing m, whose windows still fit in the text
+        while (active < classes_.size() && classes_[active].m <= n) {
+            hashes[active] = polynomialHash(text.substr(0, classes_[active].m));
+            active++;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            while (active > 0 && i + classes_[active - 1].m > n) {
+                active--;
+            }
+            size_t found = 0;
+            bool passed = false;
+            for (size_t c = 0; c < active; ++c) {
+                const LengthClass& length_class = classes_[c];
+                if (i > 0) {
+                    hashes[c] = hashes[c] * kHashBase - length_class.outgoing[s[i - 1]] + s[i + length_class.m - 1];
+                }
+                uint64_t key = hashes[c] + length_class.salt;
+                if (use_filter_ && !filter_.mayContain(key)) {
+                    continue;
+                }
+                passed = true;
+                if (exact) {
+                    if (const PatternGroups::Group* group = long_groups_.find(key)) {
+                        groups[found++] = group;
+                    }
+                }
+            }
+            bool candidate = exact ? found > 0 : passed;
+            if (short_path && !candidate) {
+                unsigned lead = s[i] | (i + 1 < n ? s[i + 1] : 0) << 8;
+                candidate = short_lead_[lead / 64] >> (lead % 64) & 1;
+            }
+            if (candidate) {
+                on_candidate(i, span<const PatternGroups::Group* const>(groups.data(), found));
+            }
+        }
+    }
+
+    // The length and the bytes of a short pattern, which fit together in 64 bits.
+    static uint64_t shortKey(const char* s, size_t length) {
+        uint64_t value = length;
+        for (size_t k = 0; k < length; ++k) {
+            value = value << 8 | (unsigned char)s[k];
+        }
+        return value;
+    }
+
+    vector<string> patterns_;
+    vector<LengthClass> classes_; // by increasing m
+    BlockedBloomFilter filter_;
+    bool use_filter_;
+    PatternGroups long_groups_;      // patterns of at least kMinFingerprint bytes, by fingerprint
+    PatternGroups short_groups_;     // shorter patterns, by shortKey
+    vector<size_t> short_lengths_;   // distinct short pattern lengths, increasing
+    vector<uint64_t> short_lead_;    // bitmap of the first two bytes of short patterns
+};
+
+/**
+ * @brief Returns the best wall time of f over a few repetitions, in milliseconds.
+ */
+template <class F>
+double measureMilliseconds(F&& f, int repetitions = 3) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief Returns a pseudo-random string of the given length over the first `alphabet` letters.
+ */
+string randomText(size_t length, int alphabet, uint64_t seed = 1) {
+    mt19937_64 generator(seed);
+    string text(length, 'a');
+    for (char& c : text) {
+        c = 'a' + generator() % alphabet;
+    }
+    return text;
+}
+
+/**
+ * @brief Returns count random patterns with lengths in [min_length, max_length].
+ */
+vector<string> randomPatterns(size_t count, size_t min_length, size_t max_length, int alphabet, uint64_t seed) {
+    mt19937_64 generator(seed);
+    vector<string> patterns(count);
+    for (string& pattern : patterns) {
+        pattern.resize(min_length + generator() % (max_length - min_length + 1));
+        for (char& c : pattern) {
+            c = 'a' + generator() % alphabet;
+        }
+    }
+    return patterns;
+}
+
+void testBlockedBloomFilter() {
+    cout << "--- Testing BlockedBloomFilter ---" << endl;
+
+    // Test case 1: No false negatives
+    BlockedBloomFilter filter(10000, 10);
+    for (uint64_t key = 0; key < 10000; ++key) {
+        filter.insert(key * 7919);
+    }
+    for (uint64_t key = 0; key < 10000; ++key) {
+        assert(filter.mayContain(key * 7919));
+    }
+    cout << "Test Case 1 (No False Negatives): Passed" << endl;
+
+    // Test case 2: False-positive rate close to the expected rate, and tunable by size
+    size_t false_positives = 0, trials = 200000;
+    for (uint64_t key = 0; key < trials; ++key) {
+        false_positives += filter.mayContain(key * 7919 + 1);
+    }
+    double rate = double(false_positives) / trials;
+    assert(rate > 0.5 * filter.expectedFalsePositiveRate() && rate < 1.5 * filter.expectedFalsePositiveRate());
+    assert(BlockedBloomFilter(10000, 20).expectedFalsePositiveRate() < filter.expectedFalsePositiveRate());
+    assert(BlockedBloomFilter(10000, 20).memoryBytes() > filter.memoryBytes());
+    cout << "Test Case 2 (False-Positive Rate): Passed" << endl;
+
+    cout << "--- BlockedBloomFilter tests completed successfully! ---" << endl << endl;
+}
+
+void testQGramFilterMatcher() {
+    cout << "--- Testing QGramFilterMatcher ---" << endl;
+
+    // Test case 1: Matches equal a naive scan, with and without short patterns
+    string text = randomText(20000, 3, 1);
+    for (size_t min_length : {3, 9}) {
+        vector<string> patterns = randomPatterns(300, min_length, min_length + 6, 3, min_length);
+        for (size_t k = 0; k < 100; ++k) {
+            patterns.push_back(text.substr(k * 197, min_length + k % 5));
+        }
+        QGramFilterMatcher matcher(patterns);
+        assert(matcher.fingerprintLengths() == vector<size_t>{max(min_length, QGramFilterMatcher::kMinFingerprint)});
+        vector<PatternMatch> expected;
+        for (size_t i = 0; i < text.length(); ++i) {
+            for (size_t id = 0; id < patterns.size(); ++id) {
+                if (string_view(text).substr(i).starts_with(patterns[id])) {
+                    expected.push_back({i, (int)id});
+                }
+            }
+        }
+        assert(expected.size() >= 100);
+        assert(matcher.search(text) == expected);
+    }
+    cout << "Test Case 1 (Naive Scan): Passed" << endl;
+
+    // Test case 2: More filter bits per pattern let fewer offsets through
+    string text2 = randomText(1 << 20, 26, 2);
+    vector<string> patterns2 = randomPatterns(100000, 8, 16, 26, 3);
+    QGramFilterMatcher small(patterns2, 6), large(patterns2, 16);
+    assert(small.filterBytes() < large.filterBytes());
+    size_t small_candidates = small.countCandidates(text2), large_candidates = large.countCandidates(text2);
+    assert(large_candidates < small_candidates);
+    assert(large_candidates < 3 * large.expectedFalsePositiveRate() * text2.length() + 100);
+    cout << "Test Case 2 (Tunable Filter): Passed" << endl;
+
+    // Test case 3: Duplicates, a match at the very end, empty set, and empty patterns
+    QGramFilterMatcher matcher3({"ab", "abc", "ab", "c"});
+    assert((matcher3.search("xabc") == vector<PatternMatch>{{1, 0}, {1, 1}, {1, 2}, {3, 3}}));
+    assert(QGramFilterMatcher({}).search("abc").empty());
+    bool threw = false;
+    try {
+        QGramFilterMatcher({"ab", ""});
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Test Case 3 (Edge Cases): Passed" << endl;
+
+    // Test case 4: A shared prefix, and short or shorter patterns next to it, leave the filter
+    // selective
+    vector<string> patterns4 = randomPatterns(20000, 8, 20, 26, 4);
+    for (string& pattern : patterns4) {
+        pattern = "https://" + pattern;
+    }
+    patterns4.push_back("ht");
+    patterns4.push_back("https:/x");
+    string text4;
+    mt19937_64 generator(5);
+    size_t urls = 4000;
+    for (size_t k = 0; k < urls; ++k) {
+        text4 += k % 10 == 0 ? patterns4[generator() % 20000]
+                 : k % 10 == 5 ? "https:/x" + randomText(24, 26, 100 + k)
+                               : "https://" + randomText(24, 26, 100 + k);
+        text4 += ' ';
+    }
+    QGramFilterMatcher matcher4(patterns4, 20);
+    assert((matcher4.fingerprintLengths() == vector<size_t>{8, 16}));
+    assert(matcher4.countCandidates(text4) < urls / 2);
+    vector<PatternMatch> expected4;
+    for (size_t i = 0; i < text4.length(); ++i) {
+        string_view rest = string_view(text4).substr(i);
+        for (size_t id = rest.starts_with("https://") ? 0 : 20000; id < patterns4.size(); ++id) {
+            if (rest.starts_with(patterns4[id])) {
+                expected4.push_back({i, (int)id});
+            }
+        }
+    }
+    assert(expected4.size() > urls + urls / 10);
+    assert(matcher4.search(text4) == expected4);
+    cout << "Test Case 4 (Shared Prefix): Passed" << endl;
+
+    cout << "--- QGramFilterMatcher tests completed successfully! ---" << endl << endl;
+}
+
+void qgramFilterMatcherSample() {
+    cout << "--- QGramFilterMatcher Sample ---" << endl;
+    string text = "GET /index.html HTTP/1.1 from 10.0.0.1";
+    QGramFilterMatcher matcher({"index.html", "HTTP/1.0", "HTTP/1.1", "10.0.0.1"});
+    cout << "Text: " << text << endl;
+    cout << "Patterns: index.html HTTP/1.0 HTTP/1.1 10.0.0.1" << endl;
+    cout << "Matches (offset:pattern): ";
+    for (const PatternMatch& match : matcher.search(text)) {
+        cout << match.offset << ":" << match.pattern_id << " ";
+    }
+    cout << endl;
+    cout << "--- QGramFilterMatcher Sample Completed ---" << endl << endl;
+}
+
+void qgramFilterBenchmark() {
+    cout << "--- QGramFilterMatcher Benchmark ---" << endl;
+    string text = randomText(16 * 1024 * 1024, 26, 4);
+    cout << "Patterns of 8 to 32 bytes, 16 MiB text; 0 bits per pattern is the exact stage alone" << endl;
+    for (size_t count : {1000, 1000000}) {
+        vector<string> patterns = randomPatterns(count, 8, 32, 26, 5);
+        for (double bits : {0.0, 8.0, 16.0}) {
+            QGramFilterMatcher matcher(patterns, bits);
+            size_t matches = 0;
+            double ms = measureMilliseconds([&] { matcher.forEachMatch(text, [&](size_t, int) { matches++; }); }, 1);
+            cout << count << " patterns, " << bits << " bits per pattern: filter " << matcher.filterBytes() / 1024
+                 << " KiB, " << matches << " matches, " << ms << " ms" << endl;
+        }
+    }
+
+    vector<string> urls = randomPatterns(200000, 8, 32, 26, 6);
+    string url_text;
+    for (size_t k = 0; url_text.length() < (1 << 20); ++k) {
+        url_text += "https://" + (k % 100 == 0 ? urls[k % urls.size()] : randomText(24, 26, k)) + " ";
+    }
+    for (string& url : urls) {
+        url = "https://" + url;
+    }
+    urls.push_back("https:/x");
+    QGramFilterMatcher url_matcher(urls);
+    size_t url_matches = 0;
+    double url_ms = measureMilliseconds([&] { url_matcher.forEachMatch(url_text, [&](size_t, int) { url_matches++; }); }, 1);
+    cout << "200000 patterns sharing the prefix https:// and one 8-byte pattern, 1 MiB text: " << url_matches
+         << " matches, " << url_ms << " ms" << endl;
+    cout << "--- QGramFilterMatcher Benchmark Completed ---" << endl << endl;
+}
+
+int main() {
+    testBlockedBloomFilter();
+    testQGramFilterMatcher();
+    qgramFilterMatcherSample();
+    qgramFilterBenchmark();
+    return 0;
+}
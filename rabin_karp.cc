@@ -0,0 +1,351 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include <bit>
+#include <span>
+#include <chrono>
+#include <compare>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+constexpr uint64_t kHashBase = 0x100000001b3; // odd, so powers of the base stay odd modulo 2^64
+
+/**
+ * @brief Polynomial hash of a string modulo 2^64: s[0] * B^(m-1) + ... + s[m-1].
+ */
+uint64_t polynomialHash(string_view s) {
+    uint64_t hash = 0;
+    for (char c : s) {
+        hash = hash * kHashBase + (unsigned char)c;
+    }
+    return hash;
+}
+
+/**
+ * @brief Computes the polynomial hashes of all windows of one length in a text.
+ *
+ * Rolling a window forward is hash * B - out * B^m + in. The weights out * B^m of the outgoing
+ * byte are precomputed for all 256 values, so each step costs one multiplication.
+ */
+class WindowHasher {
+public:
+    /**
+     * @param m The window length; must be at least 1.
+     */
+    explicit WindowHasher(size_t m) : m_(m) {
+        assert(m >= 1);
+        uint64_t power = 1;
+        for (size_t k = 0; k < m; ++k) {
+            power *= kHashBase;
+        }
+        for (int c = 0; c < 256; ++c) {
+            outgoing_[c] = c * power;
+        }
+    }
+
+    size_t windowLength() const { return m_; }
+
+    /**
+     * @brief Hashes the windows with one rolling hash.
+     *
+     * @param text The text whose windows are hashed.
+     * @param hashes Output buffer; hashes[i] is polynomialHash(text.substr(i, m)). Must hold
+     *               text.length() - m + 1 elements when m <= text.length().
+     * @note Time Complexity: O(n), one multiply-add chain through the whole text.
+     */
+    void rolling(string_view text, span<uint64_t> hashes) const {
+        if (m_ > text.length()) {
+            return;
+        }
+        size_t count = text.length() - m_ + 1;
+        assert(hashes.size() >= count);
+        const unsigned char* s = (const unsigned char*)text.data();
+        uint64_t hash = polynomialHash(text.substr(0, m_));
+        hashes[0] = hash;
+        for (size_t i = 1; i < count; ++i) {
+            hash = hash * kHashBase - outgoing_[s[i - 1]] + s[i + m_ - 1];
+            hashes[i] = hash;
+        }
+    }
+
+private:
+
+    size_t m_;
+    uint64_t outgoing_[256]; // c * B^m for every byte value c
+};
+
+/**
+ * @brief A match of one pattern out of a set, ordered by offset and then by pattern id.
+ */
+struct PatternMatch {
+    size_t offset;
+    int pattern_id;
+
+    auto operator<=>(const PatternMatch&) const = default;
+};
+
+/**
+ * @brief Rabin-Karp matcher for a large set of patterns of one length, e.g. fixed-size signatures.
+ *
+ * The pattern hashes are stored in an open-addressing table with linear probing, indexed by the
+ * high bits of the multiplied hash, so a lookup usually touches one cache line however many
+ * patterns there are; patterns sharing a hash (duplicates or collisions) are chained in
+ * increasing id order. A bitmap of 16 bits per pattern, indexed by other hash bits, sits in
+ * front of the table: it is small enough to stay in cache for large sets and rejects most
+ * windows without touching the table. The text is hashed in cache-resident blocks with
+ * WindowHasher::rolling and every hit is verified with a byte comparison, so hash collisions never produce false matches. The hash
+ * is not keyed: crafted texts can only make verification slower, not results wrong.
+ */
+class RabinKarpMatcher {
+public:
+    static constexpr size_t kBlockWindows = 4096;
+
+    /**
+     * @throws invalid_argument if the patterns do not all have the same length.
+     */
+    explicit RabinKarpMatcher(const vector<string>& patterns)
+        : patterns_(patterns), length_(patterns.empty() ? 0 : patterns[0].length()), hasher_(max<size_t>(length_, 1)),
+          next_(patterns.size(), kEmpty) {
+        for (const string& pattern : patterns_) {
+            if (pattern.length() != length_) {
+                throw invalid_argument("RabinKarpMatcher: patterns must have equal lengths");
+            }
+        }
+        size_t capacity = bit_ceil(max<size_t>(2 * patterns_.size(), 16));
+        shift_ = 64 - countr_zero(capacity);
+        slots_.assign(capacity, Slot{0, kEmpty});
+        filter_.assign(max<size_t>(capacity / 8, 1), 0); // 16 bits per pattern for full tables
+        filter_mask_ = filter_.size() * 64 - 1;
+        // Inserting in decreasing id order makes every chain list ids in increasing order.
+        for (size_t id = patterns_.size(); id-- > 0;) {
+            uint64_t hash = polynomialHash(patterns_[id]);
+            size_t index = slotIndex(hash);
+            while (slots_[index].first != kEmpty && slots_[index].hash != hash) {
+                index = (index + 1) & (slots_.size() - 1);
+            }
+            size_t bit = filterBit(hash);
+            filter_[bit / 64] |= uint64_t(1) << (bit % 64);
+            next_[id] = slots_[index].first;
+            slots_[index] = Slot{hash, (uint32_t)id};
+        }
+    }
+
+    /**
+     * @brief Calls on_match(offset, pattern_id) for every match, by offset and then by id.
+     */
+    template <class F>
+    void forEachMatch(string_view text, F&& on_match) const {
+        size_t m = length_;
+        if (m == 0 || m > text.length() || patterns_.empty()) {
+            return;
+        }
+        size_t count = text.length() - m + 1;
+        vector<uint64_t> hashes(min(count, kBlockWindows));
+        for (size_t start = 0; start < count; start += kBlockWindows) {
+            size_t windows = min(kBlockWindows, count - start);
+            hasher_.rolling(text.substr(start, windows + m - 1), hashes);
+            for (size_t k = 0; k < windows; ++k) {
+                size_t bit = filterBit(hashes[k]);
+                if (!(filter_[bit / 64] >> (bit % 64) & 1)) {
+                    continue;
+                }
+                uint32_t id = lookup(hashes[k]);
+                for (; id != kEmpty; id = next_[id]) {
+                    if (memcmp(text.data() + start + k, patterns_[id].data(), m) == 0) {
+                        on_match(start + k, (int)id);
+                    }
+                }
+            }
+        }
+    }
+
+    vector<PatternMatch> search(string_view text) const {
+        vector<PatternMatch> matches;
+        forEachMatch(text, [&](size_t offset, int id) { matches.push_back({offset, id}); });
+        return matches;
+    }
+
+    size_t patternLength() const { return length_; }
+    size_t patternCount() const { return patterns_.size(); }
+
+private:
+    static constexpr uint32_t kEmpty = numeric_limits<uint32_t>::max();
+
+    struct Slot {
+        uint64_t hash;
+        uint32_t first; // first pattern id with this hash, or kEmpty
+    };
+
+    size_t slotIndex(uint64_t hash) const { return (hash * 0x9e3779b97f4a7c15) >> shift_; }
+    size_t filterBit(uint64_t hash) const { return (hash * 0xc2b2ae3d27d4eb4f) >> 20 & filter_mask_; }
+
+    uint32_t lookup(uint64_t hash) const {
+        for (size_t index = slotIndex(hash);; index = (index + 1) & (slots_.size() - 1)) {
+            const Slot& slot = slots_[index];
+            if (slot.first == kEmpty || slot.hash == hash) {
+                return slot.first;
+            }
+        }
+    }
+
+    vector<string> patterns_;
+    size_t length_;
+    WindowHasher hasher_;
+    int shift_ = 60;
+    vector<Slot> slots_;
+    vector<uint64_t> filter_; // one bit set per pattern hash
+    size_t filter_mask_ = 0;
+    vector<uint32_t> next_; // next pattern id with the same hash, or kEmpty
+};
+
+/**
+ * @brief Returns the best wall time of f over a few repetitions, in milliseconds.
+ */
+template <class F>
+double measureMilliseconds(F&& f, int repetitions = 3) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief Returns a pseudo-random string of the given length over the first `alphabet` letters.
+ */
+string randomText(size_t length, int alphabet, uint64_t seed = 1) {
+    mt19937_64 generator(seed);
+    string text(length, 'a');
+    for (char& c : text) {
+        c = 'a' + generator() % alphabet;
+    }
+    return text;
+}
+
+void testWindowHasher() {
+    cout << "--- Testing WindowHasher ---" << endl;
+
+    // Test case 1: Every window hash equals the direct polynomial hash
+    string text = randomText(1000, 4, 1);
+    for (size_t m : {1, 7, 20, 200, 1000}) {
+        size_t count = text.length() - m + 1;
+        WindowHasher hasher(m);
+        vector<uint64_t> rolling(count);
+        hasher.rolling(text, rolling);
+        for (size_t i = 0; i < count; ++i) {
+            assert(rolling[i] == polynomialHash(string_view(text).substr(i, m)));
+        }
+    }
+    cout << "Test Case 1 (Direct Hashes): Passed" << endl;
+
+    // Test case 2: Window longer than the text
+    vector<uint64_t> none;
+    WindowHasher(4).rolling("abc", none);
+    cout << "Test Case 2 (Long Window): Passed" << endl;
+
+    cout << "--- WindowHasher tests completed successfully! ---" << endl << endl;
+}
+
+void testRabinKarpMatcher() {
+    cout << "--- Testing RabinKarpMatcher ---" << endl;
+
+    // Test case 1: Matches equal a naive scan, across block boundaries
+    string text = randomText(3 * RabinKarpMatcher::kBlockWindows + 123, 2, 2);
+    vector<string> patterns;
+    for (uint64_t seed = 0; seed < 300; ++seed) {
+        patterns.push_back(randomText(10, 2, 100 + seed));
+    }
+    vector<PatternMatch> expected;
+    for (size_t i = 0; i + 10 <= text.length(); ++i) {
+        for (size_t id = 0; id < patterns.size(); ++id) {
+            if (text.compare(i, 10, patterns[id]) == 0) {
+                expected.push_back({i, (int)id});
+            }
+        }
+    }
+    assert(!expected.empty());
+    assert(RabinKarpMatcher(patterns).search(text) == expected);
+    cout << "Test Case 1 (Naive Scan): Passed" << endl;
+
+    // Test case 2: Duplicate patterns are all reported, in id order
+    RabinKarpMatcher duplicates({"abcd", "bcda", "abcd"});
+    assert((duplicates.search("abcdabcd") ==
+            vector<PatternMatch>{{0, 0}, {0, 2}, {1, 1}, {4, 0}, {4, 2}}));
+    cout << "Test Case 2 (Duplicates): Passed" << endl;
+
+    // Test case 3: Empty set, short text, and unequal lengths
+    assert(RabinKarpMatcher({}).search("abc").empty());
+    assert(RabinKarpMatcher({"abcd"}).search("abc").empty());
+    bool threw = false;
+    try {
+        RabinKarpMatcher({"ab", "abc"});
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Test Case 3 (Edge Cases): Passed" << endl;
+
+    cout << "--- RabinKarpMatcher tests completed successfully! ---" << endl << endl;
+}
+
+void rabinKarpMatcherSample() {
+    cout << "--- RabinKarpMatcher Sample ---" << endl;
+    string text = "the cat sat on the mat with a hat";
+    RabinKarpMatcher matcher({"cat", "mat", "hat", "dog"});
+    cout << "Text: " << text << endl;
+    cout << "Patterns: cat mat hat dog" << endl;
+    cout << "Matches (offset:pattern): ";
+    for (const PatternMatch& match : matcher.search(text)) {
+        cout << match.offset << ":" << match.pattern_id << " ";
+    }
+    cout << endl;
+    cout << "--- RabinKarpMatcher Sample Completed ---" << endl << endl;
+}
+
+void rabinKarpBenchmark() {
+    cout << "--- RabinKarpMatcher Benchmark ---" << endl;
+    string text = randomText(16 * 1024 * 1024, 26, 3);
+    size_t m = 20;
+    // Hashed in cache-resident blocks, as the matcher does, so stores do not dominate.
+    WindowHasher hasher(m);
+    vector<uint64_t> hashes(RabinKarpMatcher::kBlockWindows);
+    uint64_t checksum = 0;
+    double rolling = measureMilliseconds([&] {
+        for (size_t start = 0; start + m <= text.length(); start += hashes.size()) {
+            size_t windows = min(hashes.size(), text.length() - m + 1 - start);
+            hasher.rolling(string_view(text).substr(start, windows + m - 1), hashes);
+            checksum += hashes[windows - 1];
+        }
+    });
+    vector<string> signatures;
+    for (uint64_t seed = 0; seed < 100000; ++seed) {
+        signatures.push_back(randomText(m, 26, 1000 + seed));
+    }
+    RabinKarpMatcher matcher(signatures);
+    size_t matches = 0;
+    double search = measureMilliseconds([&] { matcher.forEachMatch(text, [&](size_t, int) { matches++; }); }, 1);
+    cout << "16 MiB text, 20-byte windows" << endl;
+    cout << "window hashes: " << rolling << " ms (checksum " << checksum << ")" << endl;
+    cout << "100000 signatures: " << search << " ms (" << matches << " matches)" << endl;
+    cout << "--- RabinKarpMatcher Benchmark Completed ---" << endl << endl;
+}
+
+int main() {
+    testWindowHasher();
+    testRabinKarpMatcher();
+    rabinKarpMatcherSample();
+    rabinKarpBenchmark();
+    return 0;
+}
@@ -0,0 +1,302 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <compare>
+#include <functional>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+/**
+ * @brief A match of one pattern out of a set, ordered by offset and then by pattern id.
+ */
+struct PatternMatch {
+    size_t offset;
+    int pattern_id;
+
+    auto operator<=>(const PatternMatch&) const = default;
+};
+
+/**
+ * @brief Wu-Manber multi-pattern matcher for large sets of patterns of length at least 4.
+ *
+ * Let m be the shortest pattern length. Only the first m bytes of each pattern take part in
+ * shifting: the scan looks at the last block of B bytes of a window of length m, and the
+ * SHIFT table gives how far the window can move before that block could line up with a block
+ * of some pattern prefix, often m - B + 1 bytes. Blocks with shift 0 end some pattern prefix;
+ * the patterns of that block are kept in a bucket, sorted by id, and each is filtered by a
+ * 2-byte prefix before the full pattern is compared. As in the original paper, B is
+ * ceil(log_sigma(2 k m)) for k patterns over sigma distinct bytes, kept between 2 and 4 and at
+ * most half of m, so that most blocks of the text occur in no pattern prefix and average shifts
+ * stay long. Shifts are stored as bytes, capped at 255, to keep the SHIFT table cache resident.
+ */
+class WuManberMatcher {
+public:
+    static constexpr size_t kMinPatternLength = 4;
+
+    /**
+     * @throws invalid_argument if a pattern is shorter than kMinPatternLength.
+     */
+    explicit WuManberMatcher(const vector<string>& patterns) : patterns_(patterns) {
+        if (patterns_.empty()) {
+            return;
+        }
+        m_ = numeric_limits<size_t>::max();
+        for (const string& pattern : patterns_) {
+            if (pattern.length() < kMinPatternLength) {
+                throw invalid_argument("WuManberMatcher: patterns must have at least 4 bytes");
+            }
+            m_ = min(m_, pattern.length());
+        }
+        bool seen[256] = {};
+        for (const string& pattern : patterns_) {
+            for (char c : pattern) {
+                seen[(unsigned char)c] = true;
+            }
+        }
+        double sigma = max<double>(2, count(begin(seen), end(seen), true));
+        double blocks = 2.0 * patterns_.size() * m_;
+        block_ = clamp<size_t>(ceil(log(blocks) / log(sigma)), 2, min<size_t>(4, (m_ + 1) / 2));
+        table_bits_ = block_ == 2 ? 16 : clamp<int>(bit_width((size_t)blocks) + 1, 16, 20);
+        shift_.assign(size_t(1) << table_bits_, min<size_t>(m_ - block_ + 1, 255));
+        bucket_begin_.assign(shift_.size() + 1, 0);
+
+        for (const string& pattern : patterns_) {
+            for (size_t q = block_ - 1; q < m_; ++q) {
+                uint8_t& shift = shift_[blockHash(pattern.data() + q + 1 - block_)];
+                shift = min<size_t>(shift, m_ - 1 - q);
+            }
+            bucket_begin_[blockHash(pattern.data() + m_ - block_) + 1]++;
+        }
+        for (size_t h = 0; h < shift_.size(); ++h) {
+            bucket_begin_[h + 1] += bucket_begin_[h];
+        }
+        bucket_ids_.resize(patterns_.size());
+        bucket_prefixes_.resize(patterns_.size());
+        vector<uint32_t> fill(bucket_begin_.begin(), bucket_begin_.end() - 1);
+        for (size_t id = 0; id < patterns_.size(); ++id) {
+            uint32_t slot = fill[blockHash(patterns_[id].data() + m_ - block_)]++;
+            bucket_ids_[slot] = id;
+            bucket_prefixes_[slot] = prefix(patterns_[id].data());
+        }
+    }
+
+    /**
+     * @brief Calls on_match(offset, pattern_id) for every match, by offset and then by id.
+     */
+    template <class F>
+    void forEachMatch(string_view text, F&& on_match) const {
+        if (patterns_.empty() || text.length() < m_) {
+            return;
+        }
+        const char* s = text.data();
+        size_t n = text.length();
+        for (size_t end = m_ - 1; end < n;) {
+            uint32_t hash = blockHash(s + end + 1 - block_);
+            uint32_t shift = shift_[hash];
+            if (shift > 0) {
+                end += shift;
+                continue;
+            }
+            size_t start = end + 1 - m_;
+            uint16_t text_prefix = prefix(s + start);
+            for (uint32_t slot = bucket_begin_[hash]; slot < bucket_begin_[hash + 1]; ++slot) {
+                const string& pattern = patterns_[bucket_ids_[slot]];
+                if (bucket_prefixes_[slot] == text_prefix && pattern.length() <= n - start &&
+                    memcmp(s + start, pattern.data(), pattern.length()) == 0) {
+                    on_match(start, (int)bucket_ids_[slot]);
+                }
+            }
+            end++;
+        }
+    }
+
+    vector<PatternMatch> search(string_view text) const {
+        vector<PatternMatch> matches;
+        forEachMatch(text, [&](size_t offset, int id) { matches.push_back({offset, id}); });
+        return matches;
+    }
+
+    size_t patternCount() const { return patterns_.size(); }
+    size_t minPatternLength() const { return m_; }
+    size_t blockSize() const { return block_; }
+
+private:
+    uint32_t blockHash(const char* block) const {
+        const unsigned char* b = (const unsigned char*)block;
+        if (block_ == 2) {
+            return uint32_t(b[0]) << 8 | b[1];
+        }
+        uint32_t value = 0;
+        for (size_t k = 0; k < block_; ++k) {
+            value = value << 8 | b[k];
+        }
+        return (value * 0x9e3779b1u) >> (32 - table_bits_);
+    }
+
+    static uint16_t prefix(const char* s) { return uint16_t((unsigned char)s[0]) << 8 | (unsigned char)s[1]; }
+
+    vector<string> patterns_;
+    size_t m_ = 0;     // shortest pattern length
+    size_t block_ = 2; // bytes per block
+    int table_bits_ = 16;
+    vector<uint8_t> shift_;            // per block hash: safe shift of the window end
+    vector<uint32_t> bucket_begin_;    // per block hash: first slot of its bucket, CSR style
+    vector<uint32_t> bucket_ids_;      // pattern ids grouped by the hash of their last prefix block
+    vector<uint16_t> bucket_prefixes_; // first 2 bytes of each bucket_ids_ pattern
+};
+
+/**
+ * @brief Returns the best wall time of f over a few repetitions, in milliseconds.
+ */
+template <class F>
+double measureMilliseconds(F&& f, int repetitions = 3) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief Returns a pseudo-random string of the given length over the first `alphabet` letters.
+ */
+string randomText(size_t length, int alphabet, uint64_t seed = 1) {
+    mt19937_64 generator(seed);
+    string text(length, 'a');
+    for (char& c : text) {
+        c = 'a' + generator() % alphabet;
+    }
+    return text;
+}
+
+vector<PatternMatch> naiveSearch(string_view text, const vector<string>& patterns) {
+    vector<PatternMatch> matches;
+    for (size_t i = 0; i < text.length(); ++i) {
+        for (size_t id = 0; id < patterns.size(); ++id) {
+            if (text.substr(i).starts_with(patterns[id])) {
+                matches.push_back({i, (int)id});
+            }
+        }
+    }
+    return matches;
+}
+
+void testWuManberMatcher() {
+    cout << "--- Testing WuManberMatcher ---" << endl;
+
+    // Test case 1: Small set of mixed lengths (2-byte blocks) matches a naive scan
+    string text1 = randomText(20000, 3, 1);
+    vector<string> patterns1;
+    for (uint64_t seed = 0; seed < 50; ++seed) {
+        patterns1.push_back(randomText(4 + seed % 5, 3, 100 + seed));
+    }
+    WuManberMatcher matcher1(patterns1);
+    assert(matcher1.blockSize() == 2 && matcher1.minPatternLength() == 4);
+    vector<PatternMatch> expected1 = naiveSearch(text1, patterns1);
+    assert(!expected1.empty());
+    assert(matcher1.search(text1) == expected1);
+    cout << "Test Case 1 (Small Set): Passed" << endl;
+
+    // Test case 2: Large sets (3- and 4-byte blocks), including patterns taken from the text
+    string text2 = randomText(20000, 26, 2);
+    for (size_t min_length : {5, 8}) {
+        vector<string> patterns2;
+        mt19937_64 generator(3);
+        for (size_t k = 0; k < 2000; ++k) {
+            size_t length = min_length + generator() % 12;
+            patterns2.push_back(k % 2 ? text2.substr(generator() % (text2.length() - length), length)
+                                      : randomText(length, 26, 1000 + k));
+        }
+        WuManberMatcher matcher2(patterns2);
+        assert(matcher2.minPatternLength() == min_length && matcher2.blockSize() == (min_length == 5 ? 3 : 4));
+        vector<PatternMatch> expected2 = naiveSearch(text2, patterns2);
+        assert(expected2.size() >= 1000);
+        assert(matcher2.search(text2) == expected2);
+    }
+    cout << "Test Case 2 (Large Sets): Passed" << endl;
+
+    // Test case 3: Duplicates, a match at the very end, and a pattern longer than the rest
+    WuManberMatcher matcher3({"abcd", "cdab", "abcd", "abcdabcd"});
+    assert((matcher3.search("xabcdabcd") ==
+            vector<PatternMatch>{{1, 0}, {1, 2}, {1, 3}, {3, 1}, {5, 0}, {5, 2}}));
+    cout << "Test Case 3 (Duplicates and Text End): Passed" << endl;
+
+    // Test case 4: Empty set, short text, and too-short patterns
+    assert(WuManberMatcher({}).search("abcdef").empty());
+    assert(WuManberMatcher({"abcde"}).search("abcd").empty());
+    bool threw = false;
+    try {
+        WuManberMatcher({"abcd", "abc"});
+    } catch (const invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    cout << "Test Case 4 (Edge Cases): Passed" << endl;
+
+    cout << "--- WuManberMatcher tests completed successfully! ---" << endl << endl;
+}
+
+void wuManberMatcherSample() {
+    cout << "--- WuManberMatcher Sample ---" << endl;
+    string text = "the quick brown fox jumps over the lazy dog";
+    WuManberMatcher matcher({"quick", "jumps", "lazy", "slow"});
+    cout << "Text: " << text << endl;
+    cout << "Patterns: quick jumps lazy slow" << endl;
+    cout << "Matches (offset:pattern): ";
+    for (const PatternMatch& match : matcher.search(text)) {
+        cout << match.offset << ":" << match.pattern_id << " ";
+    }
+    cout << endl;
+    cout << "--- WuManberMatcher Sample Completed ---" << endl << endl;
+}
+
+void wuManberBenchmark() {
+    cout << "--- WuManberMatcher Benchmark ---" << endl;
+    string text = randomText(16 * 1024 * 1024, 26, 4);
+    cout << "16 MiB text, patterns of 8 to 16 bytes" << endl;
+    vector<string> patterns;
+    mt19937_64 generator(5);
+    for (size_t count : {100, 1000, 10000}) {
+        while (patterns.size() < count) {
+            patterns.push_back(randomText(8 + generator() % 9, 26, 10000 + patterns.size()));
+        }
+        WuManberMatcher matcher(patterns);
+        size_t matches = 0;
+        double wu_manber = measureMilliseconds([&] { matcher.forEachMatch(text, [&](size_t, int) { matches++; }); }, 1);
+        cout << count << " patterns, Wu-Manber: " << wu_manber << " ms (" << matches << " matches)" << endl;
+    }
+    size_t found = 0;
+    double per_pattern = measureMilliseconds([&] {
+        for (size_t id = 0; id < 100; ++id) {
+            boyer_moore_horspool_searcher searcher(patterns[id].begin(), patterns[id].end());
+            for (auto it = search(text.begin(), text.end(), searcher); it != text.end();
+                 it = search(it + 1, text.end(), searcher)) {
+                found++;
+            }
+        }
+    }, 1);
+    cout << "100 patterns, one Horspool search per pattern: " << per_pattern << " ms (" << found << " matches)" << endl;
+    cout << "--- WuManberMatcher Benchmark Completed ---" << endl << endl;
+}
+
+int main() {
+    testWuManberMatcher();
+    wuManberMatcherSample();
+    wuManberBenchmark();
+    return 0;
+}
@@ -1,29 +1,38 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstddef>
 #include <algorithm>
 #include <cassert>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <memory_resource>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 using namespace std;
 
 /**
- * @brief Computes the Z-array for a given string.
- * 
- * The Z-array is an array of the same length as the string, where each element
- * Z[i] represents the length of the longest substring starting from s[i] which
- * is also a prefix of s.
- * 
+ * @brief Computes the Z-array for a string into a caller-provided buffer.
+ *
  * @param s The input string.
- * @return A vector of integers representing the Z-array.
+ * @param Z Output buffer; must hold at least s.length() elements. Only the first s.length()
+ *          elements are written.
  * @note Time Complexity: O(n), where n is the length of the string.
- * @note Space Complexity: O(n), where n is the length of the string.
+ * @note Space Complexity: O(1) beyond the output buffer.
  */
-vector<int> computeZArray(const string& s) {
+void computeZArray(string_view s, span<int> Z) {
     int n = s.length();
+    assert(Z.size() >= (size_t)n);
     if (n == 0) {
-        return {};
+        return;
     }
-    vector<int> Z(n, 0);
     int L = 0, R = 0; // [L, R] make a window which matches prefix of s
 
     Z[0] = n;
@@ -53,9 +62,101 @@ vector<int> computeZArray(const string& s) {
             }
         }
     }
+}
+
+/**
+ * @brief Computes the Z-array for a given string.
+ * 
+ * The Z-array is an array of the same length as the string, where each element
+ * Z[i] represents the length of the longest substring starting from s[i] which
+ * is also a prefix of s.
+ * 
+ * @param s The input string.
+ * @return A vector of integers representing the Z-array.
+ * @note Time Complexity: O(n), where n is the length of the string.
+ * @note Space Complexity: O(n), where n is the length of the string.
+ */
+vector<int> computeZArray(string_view s) {
+    vector<int> Z(s.length());
+    computeZArray(s, Z);
     return Z;
 }
 
+/**
+ * @brief Computes the Z-array for a string, allocating it from a memory resource.
+ *
+ * @param s The input string.
+ * @param resource The memory resource the result is allocated from.
+ * @return The Z-array as a std::pmr::vector using resource.
+ */
+pmr::vector<int> computeZArray(string_view s, pmr::memory_resource* resource) {
+    pmr::vector<int> Z(s.length(), resource);
+    computeZArray(s, Z);
+    return Z;
+}
+
+/**
+ * @brief Runs the Z-algorithm search loop against a pattern given as raw bytes and Z table.
+ */
+template <class Table>
+void zAlgorithmSearchWithTable(string_view text, const char* pattern, const Table* Z_pattern, int n, span<int> Z) {
+    int m = text.length();
+    int L = 0, R = -1; // [L, R] defines the Z-box within the *text* matching a prefix of *pattern*
+    
+    for (int i = 0; i < m; ++i) {
+        Z[i] = 0;
+
+        if (i > R) {
+            L = R = i;
+            while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+                R++;
+            }
+            Z[i] = R-L;
+            R--;
+        }
+        else {
+            int k = i - L;
+
+            if (Z_pattern[k] < R - i + 1) {
+                Z[i] = Z_pattern[k];
+            }
+            else {
+                L = i;
+                 while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+                    R++;
+                }
+                Z[i] = R - L;
+                R--;
+            }
+        }
+        
+    }
+}
+
+/**
+ * @brief Runs the Z-algorithm search writing the pattern's Z-array and the result into caller-provided buffers.
+ *
+ * @param text The text to search within.
+ * @param pattern The pattern to search for.
+ * @param Z_pattern Scratch buffer for the pattern's Z-array; at least pattern.length() elements.
+ * @param Z Output buffer; at least text.length() elements. Z[i] receives the same value as
+ *          zAlgorithmSearch(text, pattern)[i].
+ * @note Time complexity: O(n + m) where n is the length of pattern and m is the length of text
+ * @note Space complexity: O(1) beyond the buffers
+ */
+void zAlgorithmSearch(string_view text, string_view pattern, span<int> Z_pattern, span<int> Z) {
+    int n = pattern.length();
+    int m = text.length();
+    assert(Z.size() >= (size_t)m);
+    if (n == 0) {
+        fill(Z.begin(), Z.begin() + m, 0);
+        return;
+    }
+
+    computeZArray(pattern, Z_pattern);
+    zAlgorithmSearchWithTable(text, pattern.data(), Z_pattern.data(), n, Z);
+}
+
 /**
  * @brief Implements the Z-algorithm to search for a pattern within a text.
  * 
@@ -70,50 +171,639 @@ vector<int> computeZArray(const string& s) {
  * @note Time complexity: O(n + m) where n is the length of pattern and m is the length of text
  * @note Space complexity: O(n) where n is the length of the pattern
  */
-vector<int> zAlgorithmSearch(const string& text, const string& pattern) {
+vector<int> zAlgorithmSearch(string_view text, string_view pattern) {
+    vector<int> Z_pattern(pattern.length());
+    vector<int> Z(text.length());
+    zAlgorithmSearch(text, pattern, Z_pattern, Z);
+    return Z;
+}
+
+/**
+ * @brief Runs the Z-algorithm search, allocating the pattern's Z-array and the result from a memory resource.
+ *
+ * @param text The text to search within.
+ * @param pattern The pattern to search for.
+ * @param resource The memory resource all allocations are served from.
+ * @return The same values as zAlgorithmSearch(text, pattern), as a std::pmr::vector using resource.
+ */
+pmr::vector<int> zAlgorithmSearch(string_view text, string_view pattern, pmr::memory_resource* resource) {
+    pmr::vector<int> Z_pattern(pattern.length(), resource);
+    pmr::vector<int> Z(text.length(), resource);
+    zAlgorithmSearch(text, pattern, Z_pattern, Z);
+    return Z;
+}
+
+/**
+ * @brief Views a byte buffer as a string_view, without copying.
+ */
+string_view asStringView(span<const byte> bytes) {
+    return string_view(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+/**
+ * @brief Computes the Z-array for a raw byte buffer.
+ *
+ * @param s The input bytes.
+ * @return The same values as computeZArray on the bytes viewed as characters.
+ */
+vector<int> computeZArray(span<const byte> s) {
+    return computeZArray(asStringView(s));
+}
+
+/**
+ * @brief Runs the Z-algorithm search over raw byte buffers, without copying them into strings.
+ *
+ * @param text The text bytes, e.g. an mmap'd region.
+ * @param pattern The pattern bytes.
+ * @return The same values as zAlgorithmSearch on the buffers viewed as characters.
+ */
+vector<int> zAlgorithmSearch(span<const byte> text, span<const byte> pattern) {
+    return zAlgorithmSearch(asStringView(text), asStringView(pattern));
+}
+
+/**
+ * @brief Dense match set storing one bit per text position.
+ *
+ * Bit i of words[i / 64] is set when position i is a match position. Unused bits of the last
+ * word are always zero.
+ */
+struct MatchBitmap {
+    size_t size = 0;        // number of text positions covered
+    vector<uint64_t> words; // ceil(size / 64) words
+
+    bool test(size_t i) const {
+        return (words[i >> 6] >> (i & 63)) & 1;
+    }
+};
+
+/**
+ * @brief Counts the match positions in a bitmap with one popcount per word.
+ */
+size_t countMatches(const MatchBitmap& bitmap) {
+    size_t count = 0;
+    for (uint64_t word : bitmap.words) {
+        count += popcount(word);
+    }
+    return count;
+}
+
+/**
+ * @brief Calls f(position) for every match position in a bitmap, in increasing order.
+ */
+template <class F>
+void forEachMatch(const MatchBitmap& bitmap, F&& f) {
+    for (size_t w = 0; w < bitmap.words.size(); ++w) {
+        uint64_t word = bitmap.words[w];
+        while (word != 0) {
+            f(w * 64 + countr_zero(word));
+            word &= word - 1;
+        }
+    }
+}
+
+/**
+ * @brief Runs the Z-algorithm search and records only where full matches start, one bit per text position.
+ *
+ * Bit i is set exactly when zAlgorithmSearch(text, pattern)[i] == pattern.length(). The Z values of
+ * the text are kept in the Z-box only, never stored, and each 64-bit word is written once.
+ *
+ * @param text The text to search within.
+ * @param pattern The pattern to search for.
+ * @return A MatchBitmap of text.length() bits; all zero if the pattern is empty.
+ * @note Time complexity: O(n + m) where n is the length of pattern and m is the length of text
+ * @note Space complexity: O(n + m / 64)
+ */
+MatchBitmap zAlgorithmSearchBitmap(string_view text, string_view pattern) {
     int n = pattern.length();
     int m = text.length();
-    vector<int> Z(m, 0);
+    MatchBitmap bitmap;
+    bitmap.size = m;
+    bitmap.words.assign((m + 63) / 64, 0);
     if (n == 0) {
-        return Z;
+        return bitmap;
     }
 
     vector<int> Z_pattern = computeZArray(pattern);
 
-    int L = 0, R = -1; // [L, R] defines the Z-box within the *text* matching a prefix of *pattern*
-    
+    int L = 0, R = -1;
+    uint64_t word = 0;
     for (int i = 0; i < m; ++i) {
-        Z[i] = 0;
+        int z;
+        if (i > R || Z_pattern[i - L] >= R - i + 1) {
+            L = i;
+            R = max(R, i - 1) + 1;
+            while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+                R++;
+            }
+            z = R - L;
+            R--;
+        }
+        else {
+            z = Z_pattern[i - L];
+        }
+        if (z == n) {
+            word |= uint64_t(1) << (i & 63);
+        }
+        if ((i & 63) == 63) {
+            bitmap.words[i >> 6] = word;
+            word = 0;
+        }
+    }
+    if ((m & 63) != 0) {
+        bitmap.words[m >> 6] = word;
+    }
+    return bitmap;
+}
+
+/**
+ * @brief Per-position integer profile compressed into arithmetic runs.
+ *
+ * The profile is stored as runs of the form first, first + step, first + 2 * step, ...;
+ * runs of zeros (step 0) and the ramps 1, 2, 3, ... (step 1) that make up most LPS / Z outputs
+ * both collapse to a single run. Values are appended in order and read back by position.
+ */
+class RunLengthProfile {
+public:
+    /**
+     * @brief Appends the value of the next position.
+     */
+    void push_back(int value) {
+        if (!runs_.empty()) {
+            Run& last = runs_.back();
+            size_t length = size_ - last.start;
+            if (length == 1) {
+                last.step = value - last.first;
+                size_++;
+                return;
+            }
+            if (last.first + last.step * (int)length == value) {
+                size_++;
+                return;
+            }
+        }
+        runs_.push_back({size_, value, 0});
+        size_++;
+    }
+
+    /**
+     * @brief Returns the value at position i in O(log r), where r is the number of runs.
+     */
+    int operator[](size_t i) const {
+        assert(i < size_);
+        auto it = upper_bound(runs_.begin(), runs_.end(), i,
+                              [](size_t position, const Run& run) { return position < run.start; });
+        const Run& run = *(it - 1);
+        return run.first + run.step * (int)(i - run.start);
+    }
 
+    size_t size() const { return size_; }
+    size_t runCount() const { return runs_.size(); }
+    size_t memoryBytes() const { return runs_.size() * sizeof(Run); }
+
+    /**
+     * @brief Decompresses the whole profile.
+     */
+    vector<int> expand() const {
+        vector<int> values;
+        values.reserve(size_);
+        for (size_t r = 0; r < runs_.size(); ++r) {
+            size_t end = r + 1 < runs_.size() ? runs_[r + 1].start : size_;
+            for (size_t i = runs_[r].start; i < end; ++i) {
+                values.push_back(runs_[r].first + runs_[r].step * (int)(i - runs_[r].start));
+            }
+        }
+        return values;
+    }
+
+private:
+    struct Run {
+        size_t start; // first position covered by the run
+        int first;    // value at start
+        int step;     // difference between consecutive values
+    };
+
+    vector<Run> runs_;
+    size_t size_ = 0;
+};
+
+/**
+ * @brief Runs the Z-algorithm search and returns the per-position Z values in run-length form.
+ *
+ * The result holds the same values as zAlgorithmSearch(text, pattern) but is built while
+ * scanning, without materializing the full array.
+ *
+ * @param text The text to search within.
+ * @param pattern The pattern to search for.
+ * @return The compressed profile; all zeros if the pattern is empty.
+ * @note Time complexity: O(n + m) where n is the length of pattern and m is the length of text
+ * @note Space complexity: O(n + r) where r is the number of runs in the profile
+ */
+RunLengthProfile zAlgorithmSearchRunLength(string_view text, string_view pattern) {
+    int n = pattern.length();
+    int m = text.length();
+    RunLengthProfile profile;
+    if (n == 0) {
+        for (int i = 0; i < m; ++i) {
+            profile.push_back(0);
+        }
+        return profile;
+    }
+
+    vector<int> Z_pattern = computeZArray(pattern);
+
+    int L = 0, R = -1;
+    for (int i = 0; i < m; ++i) {
+        if (i > R || Z_pattern[i - L] >= R - i + 1) {
+            L = i;
+            R = max(R, i - 1) + 1;
+            while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+                R++;
+            }
+            profile.push_back(R - L);
+            R--;
+        }
+        else {
+            profile.push_back(Z_pattern[i - L]);
+        }
+    }
+    return profile;
+}
+
+/**
+ * @brief Growable scratch buffers reused across searches.
+ *
+ * A workspace holds the pattern table and the per-position output of a search. Buffers only grow
+ * while they are too small, so once a thread has seen its largest request, further searches
+ * allocate nothing. The largest request since the last trim (the high-water mark) is tracked,
+ * and every trim_interval searches any buffer larger than that mark (and min_capacity) is
+ * shrunk back, so a single huge request does not pin memory forever. A search calls
+ * beginSearch() before taking any buffer: trimming only happens there, so the spans a search
+ * holds stay valid until the next search starts.
+ */
+class SearchWorkspace {
+public:
+    struct TrimPolicy {
+        size_t trim_interval = 1024; // searches between trims; 0 disables trimming
+        size_t min_capacity = 4096;  // elements a buffer is never trimmed below
+    };
+
+    SearchWorkspace() = default;
+    explicit SearchWorkspace(TrimPolicy policy) : policy_(policy) {}
+
+    /**
+     * @brief Starts a search, trimming first if trim_interval searches ran since the last trim.
+     */
+    void beginSearch() {
+        if (policy_.trim_interval != 0 && searches_ >= policy_.trim_interval) {
+            trim();
+        }
+        searches_++;
+    }
+
+    /**
+     * @brief Returns a pattern table buffer of the given size.
+     */
+    span<int> patternTable(size_t size) {
+        return acquire(pattern_table_, size);
+    }
+
+    /**
+     * @brief Returns an output buffer of the given size.
+     */
+    span<int> output(size_t size) {
+        return acquire(output_, size);
+    }
+
+    /**
+     * @brief Shrinks every buffer to max(high-water mark, min_capacity) and starts a new window.
+     *
+     * Spans previously returned by patternTable() and output() may be invalidated.
+     */
+    void trim() {
+        size_t keep = max(high_water_, policy_.min_capacity);
+        for (vector<int>* buffer : {&pattern_table_, &output_}) {
+            if (buffer->size() > keep) {
+                vector<int>(keep).swap(*buffer);
+                allocations_++;
+            }
+        }
+        high_water_ = 0;
+        searches_ = 0;
+    }
+
+    size_t capacity() const { return pattern_table_.size() + output_.size(); }
+    size_t highWater() const { return high_water_; }
+    size_t allocations() const { return allocations_; }
+
+private:
+    span<int> acquire(vector<int>& buffer, size_t size) {
+        high_water_ = max(high_water_, size);
+        if (buffer.size() < size) {
+            buffer.resize(max(size, buffer.size() * 2));
+            allocations_++;
+        }
+        return span<int>(buffer.data(), size);
+    }
+
+    TrimPolicy policy_;
+    vector<int> pattern_table_;
+    vector<int> output_;
+    size_t high_water_ = 0;   // largest buffer requested since the last trim
+    size_t searches_ = 0;     // searches started since the last trim
+    size_t allocations_ = 0;  // number of times a buffer was (re)allocated
+};
+
+/**
+ * @brief Returns the calling thread's search workspace.
+ */
+SearchWorkspace& threadLocalSearchWorkspace() {
+    thread_local SearchWorkspace workspace;
+    return workspace;
+}
+
+/**
+ * @brief Runs the Z-algorithm search using the buffers of a workspace.
+ *
+ * @param workspace The workspace providing the pattern's Z-array and output buffers.
+ * @param text The text to search within.
+ * @param pattern The pattern to search for.
+ * @return The same values as zAlgorithmSearch(text, pattern), as a view of the workspace's
+ *         output buffer, valid until the next search using the same workspace.
+ * @note Time complexity: O(n + m) where n is the length of pattern and m is the length of text
+ * @note Space complexity: O(n + m), allocated only when the workspace has to grow
+ */
+span<const int> zAlgorithmSearch(SearchWorkspace& workspace, string_view text, string_view pattern) {
+    workspace.beginSearch();
+    span<int> Z_pattern = workspace.patternTable(pattern.length());
+    span<int> Z = workspace.output(text.length());
+    zAlgorithmSearch(text, pattern, Z_pattern, Z);
+    return Z;
+}
+
+/**
+ * @brief Returns the best wall-clock time of f over a number of repetitions, in milliseconds.
+ */
+template <class F>
+double measureMilliseconds(F&& f, int repetitions = 3) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = chrono::steady_clock::now();
+        f();
+        chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+        best = min(best, elapsed.count());
+    }
+    return best;
+}
+
+/**
+ * @brief One pattern position of a compiled pattern: the pattern byte and its Z value.
+ */
+template <class Value>
+struct ZPatternRecord {
+    Value z_value;
+    char pattern_byte;
+
+    char byte() const { return pattern_byte; }
+    int Z() const { return z_value; }
+    void set(char b, int Z) {
+        pattern_byte = b;
+        z_value = Z;
+    }
+};
+
+/**
+ * @brief Separate pattern byte and Z value arrays, indexed like an array of ZPatternRecord.
+ */
+struct SplitZRecords {
+    struct Ref {
+        const char* pattern_byte;
+        const int* z_value;
+
+        char byte() const { return *pattern_byte; }
+        int Z() const { return *z_value; }
+    };
+
+    const char* bytes;
+    const int* values;
+
+    Ref operator[](size_t j) const { return {bytes + j, values + j}; }
+};
+
+/**
+ * @brief A pattern preprocessed once for repeated Z-algorithm searches.
+ *
+ * Patterns of up to kInlineCapacity bytes are stored as 2-byte ZPatternRecords held inline in
+ * a 64-byte aligned block, interleaving each pattern byte with its Z value, so a short pattern
+ * needs no heap allocation and fits in one or two cache lines. Longer patterns keep the bytes
+ * and the Z values in separate heap arrays: extending a Z-box reads only bytes, and
+ * interleaving them with 4-byte Z values, even packed, scans measurably slower.
+ */
+class CompiledZPattern {
+public:
+    static constexpr int kInlineCapacity = 64;
+
+    explicit CompiledZPattern(string_view pattern) : length_(pattern.length()) {
+        vector<int> Z = computeZArray(pattern);
+        if (length_ <= kInlineCapacity) {
+            fillRecords(pattern, Z, inline_records_);
+        } else {
+            heap_bytes_ = pattern;
+            heap_Z_ = move(Z);
+        }
+    }
+
+    int length() const { return length_; }
+    bool isInline() const { return length_ <= kInlineCapacity; }
+
+    /**
+     * @brief Calls f(records) with the length() pattern records: a pointer to
+     *        ZPatternRecord<uint8_t> when inline, a SplitZRecords otherwise.
+     */
+    template <class F>
+    decltype(auto) visit(F&& f) const {
+        if (isInline()) {
+            return f(static_cast<const ZPatternRecord<uint8_t>*>(inline_records_));
+        }
+        return f(SplitZRecords{heap_bytes_.data(), heap_Z_.data()});
+    }
+
+private:
+    static void fillRecords(string_view pattern, const vector<int>& Z, ZPatternRecord<uint8_t>* records) {
+        for (size_t j = 0; j < pattern.length(); ++j) {
+            records[j].set(pattern[j], Z[j]);
+        }
+    }
+
+    alignas(64) ZPatternRecord<uint8_t> inline_records_[kInlineCapacity];
+    int length_;
+    string heap_bytes_;
+    vector<int> heap_Z_;
+};
+
+/**
+ * @brief Runs the Z-algorithm search loop against an interleaved record array over text[begin, end).
+ *
+ * L and R hold the Z-box ([L, R] within the text matching a prefix of the pattern) and are
+ * updated in place, so a later call can continue at end.
+ */
+template <class Records>
+void zAlgorithmSearchWithRecords(string_view text, Records records, int n, span<int> Z, int begin, int end,
+                                 int& L, int& R) {
+    int m = text.length();
+    for (int i = begin; i < end; ++i) {
         if (i > R) {
             L = R = i;
-            while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+            while (R < m && (R - L) < n && text[R] == records[R - L].byte()) {
                 R++;
             }
-            Z[i] = R-L;
+            Z[i] = R - L;
             R--;
         }
         else {
             int k = i - L;
 
-            if (Z_pattern[k] < R - i + 1) {
-                Z[i] = Z_pattern[k];
+            if (records[k].Z() < R - i + 1) {
+                Z[i] = records[k].Z();
             }
             else {
                 L = i;
-                 while (R < m && (R - L) < n && text[R] == pattern[R - L]) {
+                while (R < m && (R - L) < n && text[R] == records[R - L].byte()) {
                     R++;
                 }
                 Z[i] = R - L;
                 R--;
             }
         }
-        
     }
+}
 
+/**
+ * @brief Runs the Z-algorithm search with a compiled pattern, writing into a caller-provided buffer.
+ *
+ * @param text The text to search within.
+ * @param pattern The compiled pattern to search for.
+ * @param Z Output buffer; at least text.length() elements. Receives the same values as
+ *          zAlgorithmSearch(text, pattern string).
+ * @note Time complexity: O(m) where m is the length of text
+ * @note Space complexity: O(1) beyond the output buffer
+ */
+void zAlgorithmSearch(string_view text, const CompiledZPattern& pattern, span<int> Z) {
+    assert(Z.size() >= text.length());
+    if (pattern.length() == 0) {
+        fill(Z.begin(), Z.begin() + text.length(), 0);
+        return;
+    }
+    pattern.visit([&](auto records) {
+        int L = 0, R = -1;
+        zAlgorithmSearchWithRecords(text, records, pattern.length(), Z, 0, text.length(), L, R);
+    });
+}
+
+/**
+ * @brief Runs the Z-algorithm search with a compiled pattern.
+ *
+ * @param text The text to search within.
+ * @param pattern The compiled pattern to search for.
+ * @return The same values as zAlgorithmSearch(text, pattern string).
+ * @note Time complexity: O(m) where m is the length of text
+ * @note Space complexity: O(m) for the result
+ */
+vector<int> zAlgorithmSearch(string_view text, const CompiledZPattern& pattern) {
+    vector<int> Z(text.length());
+    zAlgorithmSearch(text, pattern, Z);
     return Z;
 }
 
+/**
+ * @brief Shared cancellation flag; copies refer to the same flag.
+ */
+class CancellationToken {
+public:
+    void cancel() { flag_->store(true, memory_order_relaxed); }
+    bool cancelled() const { return flag_->load(memory_order_relaxed); }
+
+private:
+    shared_ptr<atomic<bool>> flag_ = make_shared<atomic<bool>>(false);
+};
+
+/**
+ * @brief Outcome of a scan run under ScanLimits.
+ */
+enum class ScanStatus {
+    Completed,        // the whole text was scanned
+    Cancelled,        // the cancellation token was triggered
+    DeadlineExceeded, // the deadline passed
+};
+
+/**
+ * @brief Limits checked by interruptible scans, once every check_interval bytes.
+ */
+struct ScanLimits {
+    const CancellationToken* token = nullptr;
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+    size_t check_interval = 64 * 1024;
+};
+
+/**
+ * @brief Returns Completed if a scan may continue, or the reason it has to stop.
+ */
+ScanStatus checkScanLimits(const ScanLimits& limits) {
+    if (limits.token != nullptr && limits.token->cancelled()) {
+        return ScanStatus::Cancelled;
+    }
+    if (limits.deadline != chrono::steady_clock::time_point::max() &&
+        chrono::steady_clock::now() >= limits.deadline) {
+        return ScanStatus::DeadlineExceeded;
+    }
+    return ScanStatus::Completed;
+}
+
+/**
+ * @brief Resume state of an interrupted Z-algorithm search.
+ */
+struct ZScanState {
+    size_t position = 0; // next text position to scan; Z[0, position) is final
+    int L = 0;           // Z-box carried over to position
+    int R = -1;
+};
+
+/**
+ * @brief Runs or resumes a Z-algorithm search that stops when a limit is hit.
+ *
+ * Scanning starts at state.position. On return, Z[0, state.position) holds the same values as
+ * zAlgorithmSearch(text, pattern) and state can be passed back to continue the scan.
+ *
+ * @param text The text to search within.
+ * @param pattern The compiled pattern to search for.
+ * @param Z Output buffer; at least text.length() elements.
+ * @param state The resume state, updated in place.
+ * @param limits The cancellation token, deadline and check interval.
+ * @return Completed once the whole text is scanned, otherwise the reason the scan stopped.
+ * @note Time complexity: O(m) in total over all resumptions, where m is the length of text
+ * @note Space complexity: O(1) beyond the output buffer
+ */
+ScanStatus zAlgorithmSearch(string_view text, const CompiledZPattern& pattern, span<int> Z, ZScanState& state,
+                            const ScanLimits& limits) {
+    assert(Z.size() >= text.length());
+    size_t interval = max<size_t>(limits.check_interval, 1);
+    while (state.position < text.length()) {
+        ScanStatus status = checkScanLimits(limits);
+        if (status != ScanStatus::Completed) {
+            return status;
+        }
+        size_t end = min(text.length(), state.position + interval);
+        if (pattern.length() == 0) {
+            fill(Z.begin() + state.position, Z.begin() + end, 0);
+        } else {
+            pattern.visit([&](auto records) {
+                zAlgorithmSearchWithRecords(text, records, pattern.length(), Z, state.position, end, state.L, state.R);
+            });
+        }
+        state.position = end;
+    }
+    return ScanStatus::Completed;
+}
+
 void testComputeZArray() {
     cout << "--- Testing computeZArray ---" << endl;
     vector<int> result;
@@ -249,6 +939,260 @@ void testZAlgorithmSearch() {
     cout << "--- zAlgorithmSearch tests completed successfully! ---" << endl << endl;
 }
 
+void testZAlgorithmSearchBitmap() {
+    cout << "--- Testing zAlgorithmSearchBitmap ---" << endl;
+    string text, pattern;
+
+    // Test Case 1: Empty Pattern
+    MatchBitmap result = zAlgorithmSearchBitmap("abc", "");
+    assert(result.size == 3 && countMatches(result) == 0);
+    cout << "Test Case 1 (Empty Pattern): Passed" << endl;
+
+    // Test Case 2: Bits mark the starts of overlapping matches
+    result = zAlgorithmSearchBitmap("aaaaa", "aa");
+    vector<size_t> starts;
+    forEachMatch(result, [&](size_t i) { starts.push_back(i); });
+    assert(starts == vector<size_t>({0, 1, 2, 3}));
+    cout << "Test Case 2 (Overlapping): Passed" << endl;
+
+    // Test Case 3: Agrees with zAlgorithmSearch across several word boundaries
+    text = "";
+    for (int k = 0; k < 300; ++k) {
+        text += (k % 5 == 0) ? "abab" : "ba";
+    }
+    pattern = "abab";
+    vector<int> Z = zAlgorithmSearch(text, pattern);
+    result = zAlgorithmSearchBitmap(text, pattern);
+    size_t expected_count = 0;
+    for (size_t i = 0; i < text.length(); ++i) {
+        bool is_start = Z[i] == (int)pattern.length();
+        expected_count += is_start;
+        assert(result.test(i) == is_start);
+    }
+    assert(countMatches(result) == expected_count);
+    cout << "Test Case 3 (Matches zAlgorithmSearch): Passed" << endl;
+
+    cout << "--- zAlgorithmSearchBitmap tests completed successfully! ---" << endl << endl;
+}
+
+void testZAlgorithmSearchRunLength() {
+    cout << "--- Testing zAlgorithmSearchRunLength ---" << endl;
+    RunLengthProfile result;
+
+    // Test Case 1: Empty Pattern
+    result = zAlgorithmSearchRunLength("abc", "");
+    assert(result.expand() == vector<int>({0, 0, 0}));
+    assert(result.runCount() == 1);
+    cout << "Test Case 1 (Empty Pattern): Passed" << endl;
+
+    // Test Case 2: Descending ramp over a run of the pattern's character
+    result = zAlgorithmSearchRunLength("xxaaaaaaxx", "aaaaaaaa");
+    assert(result.expand() == vector<int>({0, 0, 6, 5, 4, 3, 2, 1, 0, 0}));
+    assert(result.runCount() == 3);
+    assert(result[4] == 4);
+    cout << "Test Case 2 (Descending Ramp): Passed" << endl;
+
+    // Test Case 3: Same values as zAlgorithmSearch
+    vector<pair<string, string>> cases = {
+        {"GEEKS FOR GEEKS", "GEEK"},
+        {"aaaaa", "aa"},
+        {"ABABDABACDABABCABAB", "ABABCABAB"},
+        {"abc", "abcd"},
+    };
+    for (const auto& [text, pattern] : cases) {
+        vector<int> expected = zAlgorithmSearch(text, pattern);
+        result = zAlgorithmSearchRunLength(text, pattern);
+        assert(result.expand() == expected);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            assert(result[i] == expected[i]);
+        }
+    }
+    cout << "Test Case 3 (Matches zAlgorithmSearch): Passed" << endl;
+
+    cout << "--- zAlgorithmSearchRunLength tests completed successfully! ---" << endl << endl;
+}
+
+void testCallerProvidedBuffers() {
+    cout << "--- Testing caller-provided buffers and PMR overloads ---" << endl;
+    string text = "ABABDABACDABABCABAB";
+    string pattern = "ABABCABAB";
+
+    // Test Case 1: computeZArray into a span
+    int buffer[8];
+    fill(begin(buffer), end(buffer), -1);
+    computeZArray("aaaaa", span<int>(buffer, 8));
+    assert(vector<int>(buffer, buffer + 5) == vector<int>({5, 4, 3, 2, 1}));
+    assert(buffer[5] == -1);
+    cout << "Test Case 1 (computeZArray Span): Passed" << endl;
+
+    // Test Case 2: zAlgorithmSearch into spans matches the vector overload
+    vector<int> scratch(pattern.length());
+    vector<int> out(text.length(), -1);
+    zAlgorithmSearch(text, pattern, scratch, out);
+    assert(out == zAlgorithmSearch(text, pattern));
+    zAlgorithmSearch("abc", "", scratch, out);
+    assert(out[0] == 0 && out[2] == 0);
+    cout << "Test Case 2 (zAlgorithmSearch Span): Passed" << endl;
+
+    // Test Case 3: PMR overloads serve every allocation from the arena
+    alignas(max_align_t) char arena[4096];
+    pmr::monotonic_buffer_resource resource(arena, sizeof(arena), pmr::null_memory_resource());
+    pmr::vector<int> Z_pattern = computeZArray(pattern, &resource);
+    pmr::vector<int> Z = zAlgorithmSearch(text, pattern, &resource);
+    assert(vector<int>(Z_pattern.begin(), Z_pattern.end()) == computeZArray(pattern));
+    assert(vector<int>(Z.begin(), Z.end()) == zAlgorithmSearch(text, pattern));
+    cout << "Test Case 3 (PMR Arena): Passed" << endl;
+
+    cout << "--- caller-provided buffer tests completed successfully! ---" << endl << endl;
+}
+
+void testSearchWorkspace() {
+    cout << "--- Testing SearchWorkspace ---" << endl;
+    SearchWorkspace workspace;
+    span<const int> result;
+
+    // Test Case 1: Workspace search matches zAlgorithmSearch
+    result = zAlgorithmSearch(workspace, "GEEKS FOR GEEKS", "GEEK");
+    assert(vector<int>(result.begin(), result.end()) == zAlgorithmSearch("GEEKS FOR GEEKS", "GEEK"));
+    result = zAlgorithmSearch(workspace, "abc", "");
+    assert(vector<int>(result.begin(), result.end()) == vector<int>({0, 0, 0}));
+    cout << "Test Case 1 (Matches zAlgorithmSearch): Passed" << endl;
+
+    // Test Case 2: No allocations after warm-up
+    zAlgorithmSearch(workspace, string(1000, 'a'), "aab");
+    size_t warm_allocations = workspace.allocations();
+    for (int k = 0; k < 100; ++k) {
+        zAlgorithmSearch(workspace, string(500 + k, 'a'), "aaab");
+    }
+    assert(workspace.allocations() == warm_allocations);
+    cout << "Test Case 2 (Steady State): Passed" << endl;
+
+    // Test Case 3: A one-off large request is trimmed back once a full interval passes without it
+    SearchWorkspace trimmed({4, 16});
+    zAlgorithmSearch(trimmed, string(10000, 'x'), "xy");
+    for (int k = 0; k < 8; ++k) {
+        zAlgorithmSearch(trimmed, "xxyxy", "xy");
+    }
+    assert(trimmed.capacity() <= 32);
+    cout << "Test Case 3 (Trim Policy): Passed" << endl;
+
+    // Test Case 4: A trim never frees buffers a running search already holds
+    SearchWorkspace trimming({2, 16});
+    string pattern = string(5000, 'a') + "b";
+    zAlgorithmSearch(trimming, pattern + "a", pattern);
+    for (int k = 0; k < 6; ++k) {
+        result = zAlgorithmSearch(trimming, "aabaab", "aab");
+        assert(vector<int>(result.begin(), result.end()) == zAlgorithmSearch("aabaab", "aab"));
+    }
+    assert(trimming.capacity() <= 32);
+    cout << "Test Case 4 (Trim Between Searches): Passed" << endl;
+
+    cout << "--- SearchWorkspace tests completed successfully! ---" << endl << endl;
+}
+
+void testCompiledZPattern() {
+    cout << "--- Testing CompiledZPattern ---" << endl;
+
+    // Test Case 1: Short patterns are stored inline
+    assert(CompiledZPattern("GEEK").isInline());
+    assert(CompiledZPattern(string(64, 'a')).isInline());
+    assert(!CompiledZPattern(string(65, 'a')).isInline());
+    cout << "Test Case 1 (Inline Storage): Passed" << endl;
+
+    // Test Case 2: Inline and heap patterns search like zAlgorithmSearch
+    string text;
+    for (int k = 0; k < 50; ++k) {
+        text += string(k % 70, 'a') + "b";
+    }
+    for (int length : {1, 3, 63, 64, 65, 69}) {
+        string pattern = string(length - 1, 'a') + "b";
+        assert(zAlgorithmSearch(text, CompiledZPattern(pattern)) == zAlgorithmSearch(text, pattern));
+        pattern = "b" + string(length - 1, 'a');
+        assert(zAlgorithmSearch(text, CompiledZPattern(pattern)) == zAlgorithmSearch(text, pattern));
+    }
+    cout << "Test Case 2 (Matches zAlgorithmSearch): Passed" << endl;
+
+    // Test Case 3: Empty Pattern
+    assert(zAlgorithmSearch("abc", CompiledZPattern("")) == vector<int>({0, 0, 0}));
+    cout << "Test Case 3 (Empty Pattern): Passed" << endl;
+
+    cout << "--- CompiledZPattern tests completed successfully! ---" << endl << endl;
+}
+
+void testZeroCopyEntryPoints() {
+    cout << "--- Testing string_view and byte span entry points ---" << endl;
+
+    // Test Case 1: Views into a larger buffer, without copies
+    const char* buffer = "xxGEEKS FOR GEEKSxx";
+    string_view text(buffer + 2, 15);
+    assert(zAlgorithmSearch(text, text.substr(0, 4)) == zAlgorithmSearch("GEEKS FOR GEEKS", "GEEK"));
+    assert(computeZArray(text.substr(0, 5)) == computeZArray("GEEKS"));
+    cout << "Test Case 1 (string_view): Passed" << endl;
+
+    // Test Case 2: Byte spans
+    vector<byte> bytes;
+    for (char c : string("aaaaa")) {
+        bytes.push_back(static_cast<byte>(c));
+    }
+    span<const byte> all(bytes);
+    assert(zAlgorithmSearch(all, all.first(2)) == vector<int>({2, 2, 2, 2, 1}));
+    assert(computeZArray(all) == vector<int>({5, 4, 3, 2, 1}));
+    cout << "Test Case 2 (Byte Span): Passed" << endl;
+
+    cout << "--- string_view and byte span tests completed successfully! ---" << endl << endl;
+}
+
+void testScanLimits() {
+    cout << "--- Testing cancellation tokens and deadlines ---" << endl;
+    string text;
+    for (int k = 0; k < 5000; ++k) {
+        text += (k % 3 == 0) ? "aab" : "ab";
+    }
+    string pattern = "abaabab";
+    CompiledZPattern compiled(pattern);
+    vector<int> expected = zAlgorithmSearch(text, pattern);
+
+    // Test Case 1: No limits completes in one call
+    vector<int> Z(text.length());
+    ZScanState state;
+    assert(zAlgorithmSearch(text, compiled, Z, state, ScanLimits()) == ScanStatus::Completed);
+    assert(Z == expected);
+    cout << "Test Case 1 (No Limits): Passed" << endl;
+
+    // Test Case 2: A past deadline stops at once
+    ScanLimits expired;
+    expired.deadline = chrono::steady_clock::now() - chrono::seconds(1);
+    state = ZScanState();
+    assert(zAlgorithmSearch(text, compiled, Z, state, expired) == ScanStatus::DeadlineExceeded);
+    assert(state.position == 0);
+    cout << "Test Case 2 (Deadline): Passed" << endl;
+
+    // Test Case 3: Cancelling from another thread keeps the partial result; resuming finishes it
+    string long_text;
+    while (long_text.length() < 4 * 1024 * 1024) {
+        long_text += text;
+    }
+    vector<int> long_expected = zAlgorithmSearch(long_text, pattern);
+    vector<int> long_Z(long_text.length());
+    CancellationToken token;
+    ScanLimits limits;
+    limits.token = &token;
+    limits.check_interval = 4096;
+    state = ZScanState();
+    thread canceller([&] { token.cancel(); });
+    ScanStatus status = zAlgorithmSearch(long_text, compiled, long_Z, state, limits);
+    canceller.join();
+    if (status == ScanStatus::Cancelled) {
+        assert(state.position % 4096 == 0 && state.position < long_text.length());
+        assert(equal(long_Z.begin(), long_Z.begin() + state.position, long_expected.begin()));
+    }
+    assert(zAlgorithmSearch(long_text, compiled, long_Z, state, ScanLimits()) == ScanStatus::Completed);
+    assert(long_Z == long_expected);
+    cout << "Test Case 3 (Cancel and Resume): Passed" << endl;
+
+    cout << "--- cancellation and deadline tests completed successfully! ---" << endl << endl;
+}
+
 void computeZArraySample() {
     cout << "--- computeZArray Sample ---" << endl;
     string s = "aabaabcaxaabaabcy";
@@ -277,10 +1221,49 @@ void zAlgorithmSearchSample() {
      cout << "--- zAlgorithmSearch Sample Completed ---" << endl << endl;
 }
 
+void compiledZPatternBenchmark() {
+    cout << "--- CompiledZPattern Benchmark ---" << endl;
+    // A periodic pattern larger than L1 and a text of its copies with sparse mutations, so
+    // Z values of the pattern are reused from deep inside it.
+    string period = "aabaabaabaac";
+    string pattern;
+    while (pattern.length() < 256 * 1024) {
+        pattern += period;
+    }
+    mt19937_64 generator(11);
+    string text;
+    while (text.length() < 4 * 1024 * 1024) {
+        string copy = pattern;
+        for (size_t k = 0; k < copy.length(); k += 4096) {
+            copy[(k + generator() % 4096) % copy.length()] = 'x';
+        }
+        text += copy;
+    }
+    vector<int> Z(text.length());
+    vector<int> Z_pattern = computeZArray(pattern);
+    CompiledZPattern compiled(pattern);
+    double separate = measureMilliseconds([&] {
+        zAlgorithmSearchWithTable(text, pattern.data(), Z_pattern.data(), pattern.length(), Z);
+    });
+    double compiled_ms = measureMilliseconds([&] { zAlgorithmSearch(text, compiled, Z); });
+    cout << "256 KiB pattern, 4 MiB text" << endl;
+    cout << "separate pattern/Z arrays: " << separate << " ms" << endl;
+    cout << "CompiledZPattern: " << compiled_ms << " ms" << endl;
+    cout << "--- CompiledZPattern Benchmark Completed ---" << endl << endl;
+}
+
 int main() {
     testComputeZArray();
     testZAlgorithmSearch();
+    testZAlgorithmSearchBitmap();
+    testZAlgorithmSearchRunLength();
+    testCallerProvidedBuffers();
+    testSearchWorkspace();
+    testCompiledZPattern();
+    testZeroCopyEntryPoints();
+    testScanLimits();
     computeZArraySample();
     zAlgorithmSearchSample();
+    compiledZPatternBenchmark();
     return 0;
 }
\ No newline at end of file